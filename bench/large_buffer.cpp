@@ -0,0 +1,102 @@
+/**
+ * @brief Benchmark of LargeBuffer with every BufferPolicy: time to fill the buffer with Serialize<>::write_to (page faults included) and
+ * time of random reads in it (TLB misses), with normal, transparent and explicit huge pages, bound to the local NUMA node or not.
+ * 
+ * g++ -std=c++17 -O2 -Iinclude bench/large_buffer.cpp -o large_buffer && ./large_buffer [buffer MB]
+ */
+#include "Metaserializer/LargeBuffer.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+using namespace Metaserializer;
+
+struct Tick
+{
+    std::uint64_t id;
+    double price;
+    double quantity;
+    std::uint32_t venue;
+    std::uint32_t flags;
+};
+
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Anonymous memory of the process backed by transparent huge pages, in KB.
+ * 
+ */
+static size_t anon_huge_pages()
+{
+    std::ifstream smaps("/proc/self/smaps_rollup");
+    std::string key;
+    size_t value = 0;
+    while (smaps >> key)
+    {
+        if (key == "AnonHugePages:")
+        {
+            smaps >> value;
+            return value;
+        }
+        smaps.ignore(1 << 10, '\n');
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const size_t buffer_size = (argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 512) << 20;
+    const size_t ticks = buffer_size / sizeof(Tick);
+    const size_t reads = 20000000;
+    const char *names[] = {"none", "transparent", "explicit"};
+    volatile std::uint64_t sink = 0;
+
+    std::printf("buffer %zu MB\n", buffer_size >> 20);
+    std::printf("%-12s %-6s %-12s %-6s %14s %10s %14s\n", "policy", "numa", "pages", "bound", "THP MB", "fill GB/s", "random read ns");
+    for (int pages = 0; pages < 3; ++pages)
+    {
+        for (int numa = 0; numa < 2; ++numa)
+        {
+            BufferPolicy policy;
+            policy.huge_pages = static_cast<BufferPolicy::HugePages>(pages);
+            policy.numa_node = numa ? BufferPolicy::local_node : BufferPolicy::no_node;
+            const size_t huge_before = anon_huge_pages();
+
+            LargeBuffer buffer(buffer_size, policy);
+            Tick tick = {};
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < ticks; ++i)
+            {
+                tick.id = i;
+                tick.price = static_cast<double>(i) * 0.25;
+                Serialize<>::write_to(buffer, tick);
+            }
+            const double fill = static_cast<double>(buffer.size()) / seconds_since(start) / 1e9;
+            const size_t huge = anon_huge_pages() - huge_before;
+
+            // Dependent random reads, every one can miss the TLB.
+            std::uint64_t state = 88172645463325252ull, value = 0;
+            const size_t words = buffer.size() / sizeof(std::uint64_t);
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < reads; ++i)
+            {
+                state ^= state << 13;
+                state ^= state >> 7;
+                state ^= state << 17;
+                std::uint64_t word;
+                std::memcpy(&word, buffer.data() + ((state ^ value) % words) * sizeof(std::uint64_t), sizeof(word));
+                value = word & 1;
+            }
+            sink = sink + value;
+            const double random = seconds_since(start) / reads * 1e9;
+
+            std::printf("%-12s %-6s %-12s %-6s %14zu %10.2f %14.1f\n", names[pages], numa ? "local" : "any", names[static_cast<int>(buffer.huge_pages())],
+                        buffer.numa_bound() ? "yes" : "no", huge >> 10, fill, random);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,126 @@
+/**
+ * @brief Benchmark of Prefetch::distance(): time per element of the decode of arrays of complex objects, RecordBatch::for_each,
+ * RecordBatch::decode and RecordSort::apply (which gathers the records in random order) for every distance, on a data set bigger
+ * than the last level cache.
+ * 
+ * g++ -std=c++17 -O2 -Iinclude bench/prefetch.cpp -o prefetch && ./prefetch [data set MB]
+ */
+#include "Metaserializer/RecordSort.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+using namespace Metaserializer;
+
+struct Order
+{
+    int id;
+    std::string symbol;
+    double price[3];
+
+    std::string serialize()
+    {
+        return Serialize<>::apply(id, symbol, price);
+    }
+
+    size_t unserialize(std::string &data)
+    {
+        return Unserialize<>::apply(data, id, symbol, price);
+    }
+};
+
+static const size_t array_size = 64; //< Every complex element is unserialized from a copy of the remaining bytes, so arrays stay small.
+using OrderArray = Order[array_size];
+
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char **argv)
+{
+    const size_t data_size = (argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 512) << 20;
+    const size_t distances[] = {0, 1, 2, 4, 8, 16, 32};
+
+    // Arrays of orders serialized one after the other, decoded into as many destination arrays.
+    std::unique_ptr<OrderArray[]> source(new OrderArray[1]);
+    for (size_t i = 0; i < array_size; ++i)
+    {
+        source[0][i].id = static_cast<int>(i);
+        source[0][i].symbol.assign(i % 16, 's');
+        source[0][i].price[2] = static_cast<double>(i);
+    }
+    std::string arrays;
+    StringSink array_sink(arrays);
+    size_t array_count = 0;
+    while (arrays.size() < data_size)
+    {
+        Serialize<>::to(array_sink, source[0]);
+        ++array_count;
+    }
+    const size_t array_bytes = arrays.size() / array_count;
+    std::unique_ptr<OrderArray[]> destination(new OrderArray[array_count]);
+
+    std::string batch;
+    StringSink batch_sink(batch);
+    size_t records = 0;
+    while (batch.size() < data_size)
+    {
+        RecordWriter::append(batch_sink, source[0][records % array_size]);
+        ++records;
+    }
+    // Records keyed by a random id, RecordSort gathers them in the order of the ids.
+    std::string unsorted, sorted;
+    StringSink unsorted_sink(unsorted);
+    std::uint64_t key = 88172645463325252ull;
+    std::string payload(40, 'p');
+    size_t sort_records = 0;
+    while (unsorted.size() < data_size)
+    {
+        key ^= key << 13;
+        key ^= key >> 7;
+        key ^= key << 17;
+        RecordWriter::append(unsorted_sink, key, payload);
+        ++sort_records;
+    }
+    sorted.reserve(unsorted.size());
+
+    std::vector<Order> out;
+    out.reserve(records);
+    volatile long sum = 0;
+    RecordBatch<Order>::decode(batch, out); // The first pass faults the pages of the vector in.
+
+    std::printf("arrays %zu MB, records %zu MB, sorted records %zu MB\n", arrays.size() >> 20, batch.size() >> 20, unsorted.size() >> 20);
+    std::printf("%8s %14s %14s %14s %14s\n", "distance", "array ns", "for_each ns", "decode ns", "sort ns");
+    for (size_t distance : distances)
+    {
+        Prefetch::distance().store(distance);
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < array_count; ++i)
+        {
+            std::string_view bytes(arrays.data() + i * array_bytes, array_bytes);
+            Unserialize<>::apply(bytes, destination[i]);
+        }
+        const double array = seconds_since(start) / (array_count * array_size) * 1e9;
+
+        start = std::chrono::steady_clock::now();
+        RecordBatch<Order>::for_each(batch, [&sum](const Order &order) { sum = sum + order.id; });
+        const double for_each = seconds_since(start) / records * 1e9;
+
+        out.clear();
+        start = std::chrono::steady_clock::now();
+        RecordBatch<Order>::decode(batch, out);
+        const double decode = seconds_since(start) / records * 1e9;
+
+        sorted.clear();
+        StringSink sorted_sink(sorted);
+        start = std::chrono::steady_clock::now();
+        RecordSort<0, std::uint64_t, std::string>::apply(unsorted, sorted_sink);
+        const double sort = seconds_since(start) / sort_records * 1e9;
+
+        std::printf("%8zu %14.1f %14.1f %14.1f %14.1f\n", distance, array, for_each, decode, sort);
+    }
+    return 0;
+}
@@ -0,0 +1,76 @@
+/**
+ * @brief Benchmark of StreamingCopy: throughput of memcpy and of the non-temporal stores for every copy size, and the time to read
+ * again a working set which was in the cache before the copy (what the copy evicted from it).
+ * 
+ * g++ -std=c++17 -O2 -Iinclude bench/streaming_copy.cpp -o streaming_copy && ./streaming_copy [working set MB]
+ */
+#include "Metaserializer.hpp"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace Metaserializer;
+
+static double seconds_since(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Read one byte of every cache line of the working set.
+ * 
+ */
+static size_t touch(const std::vector<unsigned char> &working_set)
+{
+    size_t sum = 0;
+    for (size_t i = 0; i < working_set.size(); i += 64)
+    {
+        sum += working_set[i];
+    }
+    return sum;
+}
+
+int main(int argc, char **argv)
+{
+    const size_t working_set_size = (argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1) << 20;
+    const size_t max_size = size_t(256) << 20;
+    std::vector<unsigned char> source(max_size, 1), destination(max_size, 0), working_set(working_set_size, 1);
+    volatile size_t sink = 0;
+
+    std::printf("working set %zu KB\n", working_set_size >> 10);
+    std::printf("%10s %12s %12s %16s %16s\n", "size KB", "memcpy GB/s", "stream GB/s", "memcpy reload ns", "stream reload ns");
+    for (size_t size = StreamingCopy::min_size; size <= max_size; size *= 2)
+    {
+        const size_t repeats = std::max<size_t>(8, (size_t(2) << 30) / size);
+        double throughput[2], reload[2];
+        for (int streaming = 0; streaming < 2; ++streaming)
+        {
+            StreamingCopy::threshold().store(streaming ? 0 : SIZE_MAX);
+            StreamingCopy::copy(destination.data(), source.data(), size);
+
+            const auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < repeats; ++i)
+            {
+                StreamingCopy::copy(destination.data(), source.data(), size);
+            }
+            throughput[streaming] = static_cast<double>(size) * repeats / seconds_since(start) / 1e9;
+
+            // Warm the working set, copy, then time how long it takes to read it again.
+            const size_t rounds = std::min<size_t>(repeats, 64);
+            double total = 0;
+            for (size_t i = 0; i < rounds; ++i)
+            {
+                sink = sink + touch(working_set);
+                sink = sink + touch(working_set);
+                StreamingCopy::copy(destination.data(), source.data(), size);
+                const auto reload_start = std::chrono::steady_clock::now();
+                sink = sink + touch(working_set);
+                total += seconds_since(reload_start);
+            }
+            reload[streaming] = total / rounds * 1e9;
+        }
+        std::printf("%10zu %12.2f %12.2f %16.0f %16.0f\n", size >> 10, throughput[0], throughput[1], reload[0], reload[1]);
+    }
+    return 0;
+}
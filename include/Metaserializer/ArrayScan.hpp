@@ -0,0 +1,370 @@
+#pragma once
+
+#include "../Metaserializer.hpp"
+#if defined(__x86_64__) || defined(_M_X64)
+#include <immintrin.h>
+#endif
+
+/**
+ * @brief Aggregations over one member of a serialized array of simple objects (the bytes written by Serialize<>::apply for a T[N]),
+ * reading the member straight from the serialized records with its offset and the record stride, so the objects are never decoded.
+ * 
+ * [serial_size_t count][record 0][record 1]... every record has sizeof(T) bytes, or PackedObject<T>::size when T is packed.
+ */
+namespace Metaserializer
+{
+    /**
+     * @brief How the member is read from the records.
+     * 
+     */
+    enum class ScanMethod
+    {
+        strided, //< Every value is loaded from its record.
+        blocked, //< Values are copied by blocks to a contiguous buffer which fits the L1 cache and reduced with vector instructions.
+        gather   //< As blocked but the block is filled with AVX2 gather instructions, blocked when the CPU doesn't have them.
+    };
+
+    /**
+     * @brief Aggregations over the member of a serialized T[N], e.g. ArrayScan<&Trade::price>::aggregate(bytes).
+     * 
+     * @tparam Member Pointer to an arithmetic member of T.
+     */
+    template <auto Member>
+    class ArrayScan;
+
+    template <typename T, typename M, M T::*Member>
+    class ArrayScan<Member>
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "Scanned records must be trivially copyable.");
+        static_assert(std::is_arithmetic<M>::value, "Scanned member must be arithmetic.");
+
+    public:
+        using sum_t = typename std::conditional<std::is_floating_point<M>::value, double,
+                                                typename std::conditional<std::is_signed<M>::value, std::int64_t, std::uint64_t>::type>::type;
+
+        static constexpr size_t lanes = 8;        //< Independent accumulators, enough for the compiler to use vector registers.
+        static constexpr size_t block_size = 512; //< Values per block in the blocked and gather methods.
+
+        /**
+         * @brief Records of a serialized array.
+         * 
+         */
+        struct View
+        {
+            const unsigned char *records;
+            size_t count;
+        };
+
+        /**
+         * @brief Result of aggregate, min and max are the limits of M when there are no records.
+         * 
+         */
+        struct Aggregate
+        {
+            size_t count = 0;
+            sum_t sum = 0;
+            M min = std::numeric_limits<M>::max();
+            M max = std::numeric_limits<M>::lowest();
+        };
+
+        /**
+         * @brief Bytes between records.
+         * 
+         */
+        static size_t stride()
+        {
+            if constexpr (PackedLayout<T>::value)
+            {
+                return PackedObject<T>::size;
+            }
+            else
+            {
+                return sizeof(T);
+            }
+        }
+
+        /**
+         * @brief Offset of the member in a serialized record, computed once.
+         * 
+         */
+        static size_t offset()
+        {
+            static const size_t value = compute_offset();
+            return value;
+        }
+
+        /**
+         * @brief Get the records of the bytes of a serialized T[N] field (e.g. at Unserialize<>::offset_of).
+         * 
+         * @param bytes Bytes starting at the array count.
+         * @return View Records of the array.
+         */
+        static View from(std::string_view bytes)
+        {
+            serial_size_t count;
+            if (bytes.size() < sizeof(serial_size_t))
+            {
+                throw std::runtime_error("Error while scanning array, buffer bytes remaining are too low to continue.");
+            }
+            std::memcpy(&count, bytes.data(), sizeof(serial_size_t));
+            if (count < 0 || static_cast<size_t>(count) * stride() > bytes.size() - sizeof(serial_size_t))
+            {
+                throw std::runtime_error("Error while scanning array, can't read bytes indicated in byte size serialization.");
+            }
+            return View{reinterpret_cast<const unsigned char *>(bytes.data()) + sizeof(serial_size_t), static_cast<size_t>(count)};
+        }
+
+        /**
+         * @brief Get the records of the field I of a message serialized with the datatypes TArgs.
+         * 
+         * @tparam I Index of the T[N] field.
+         * @tparam TArgs Datatypes given to Serialize<>::apply.
+         * @param message Serialized message.
+         * @return View Records of the array.
+         */
+        template <size_t I, typename... TArgs>
+        static View field(std::string_view message)
+        {
+            using F = typename std::tuple_element<I, std::tuple<TArgs...>>::type;
+            static_assert(std::is_array<F>::value && std::is_same<typename std::remove_extent<F>::type, T>::value, "Field is not an array of T.");
+            return from(message.substr(Unserialize<>::offset_of<I, TArgs...>(message)));
+        }
+
+        /**
+         * @brief Count, sum, min and max of the member in one pass.
+         * 
+         * @param view Records of the array.
+         * @param method How the member is read.
+         * @return Aggregate Aggregations of the member.
+         */
+        static Aggregate aggregate(View view, ScanMethod method = ScanMethod::blocked)
+        {
+            Aggregate result;
+            scan(view, method, [&result](size_t n, auto load) { merge(result, reduce(n, load)); });
+            return result;
+        }
+
+        static sum_t sum(View view, ScanMethod method = ScanMethod::blocked)
+        {
+            return aggregate(view, method).sum;
+        }
+
+        static M min(View view, ScanMethod method = ScanMethod::blocked)
+        {
+            return aggregate(view, method).min;
+        }
+
+        static M max(View view, ScanMethod method = ScanMethod::blocked)
+        {
+            return aggregate(view, method).max;
+        }
+
+        /**
+         * @brief Count the records where the member is in [low, high].
+         * 
+         * @param view Records of the array.
+         * @param low Smallest value counted.
+         * @param high Biggest value counted.
+         * @param method How the member is read.
+         * @return size_t Number of records.
+         */
+        static size_t count_where(View view, M low, M high, ScanMethod method = ScanMethod::blocked)
+        {
+            size_t result = 0;
+            scan(view, method, [&result, low, high](size_t n, auto load) {
+                size_t counts[lanes] = {};
+                const size_t full = n / lanes * lanes;
+                for (size_t i = 0; i < full; i += lanes)
+                {
+                    for (size_t l = 0; l < lanes; ++l)
+                    {
+                        const M value = load(i + l);
+                        counts[l] += (value >= low) & (value <= high);
+                    }
+                }
+                for (size_t i = full; i < n; ++i)
+                {
+                    const M value = load(i);
+                    counts[0] += (value >= low) & (value <= high);
+                }
+                for (size_t l = 0; l < lanes; ++l)
+                {
+                    result += counts[l];
+                }
+            });
+            return result;
+        }
+
+    private:
+        static size_t compute_offset()
+        {
+            static_assert(std::is_default_constructible<T>::value, "Scanned records must be default constructible.");
+            const T probe{};
+            const unsigned char *base = reinterpret_cast<const unsigned char *>(&probe);
+            const unsigned char *member = reinterpret_cast<const unsigned char *>(&(probe.*Member));
+            if constexpr (PackedLayout<T>::value)
+            {
+                // Members are written one after the other, the offset is the size of the members before it.
+                size_t packed = 0, result = 0;
+                AggregateReflection<T>::for_each(probe, [&](const auto &field) {
+                    using F = typename std::remove_cv<typename std::remove_reference<decltype(field)>::type>::type;
+                    if (reinterpret_cast<const unsigned char *>(&field) == member)
+                    {
+                        result = packed;
+                    }
+                    packed += PackedObject<T>::template field_size<F>();
+                });
+                return result;
+            }
+            else
+            {
+                return static_cast<size_t>(member - base);
+            }
+        }
+
+        static M load_strided(const unsigned char *records, size_t i)
+        {
+            M value;
+            std::memcpy(&value, records + i * stride() + offset(), sizeof(M));
+            return value;
+        }
+
+        /**
+         * @brief Call the kernel with the values of the records, all at once (strided) or by blocks copied to a contiguous buffer.
+         * 
+         */
+        template <typename Kernel>
+        static void scan(View view, ScanMethod method, Kernel &&kernel)
+        {
+            if (method == ScanMethod::strided)
+            {
+                const unsigned char *records = view.records;
+                kernel(view.count, [records](size_t i) { return load_strided(records, i); });
+                return;
+            }
+
+            M block[block_size];
+            const bool use_gather = method == ScanMethod::gather && gather_supported();
+            for (size_t first = 0; first < view.count; first += block_size)
+            {
+                const size_t n = std::min(block_size, view.count - first);
+                const unsigned char *records = view.records + first * stride();
+                if (use_gather)
+                {
+                    gather(records, n, block);
+                }
+                else
+                {
+                    for (size_t i = 0; i < n; ++i)
+                    {
+                        block[i] = load_strided(records, i);
+                    }
+                }
+                const M *values = block;
+                kernel(n, [values](size_t i) { return values[i]; });
+            }
+        }
+
+        template <typename Load>
+        static Aggregate reduce(size_t n, Load load)
+        {
+            sum_t sums[lanes] = {};
+            M mins[lanes], maxs[lanes];
+            for (size_t l = 0; l < lanes; ++l)
+            {
+                mins[l] = std::numeric_limits<M>::max();
+                maxs[l] = std::numeric_limits<M>::lowest();
+            }
+            const size_t full = n / lanes * lanes;
+            for (size_t i = 0; i < full; i += lanes)
+            {
+                for (size_t l = 0; l < lanes; ++l)
+                {
+                    const M value = load(i + l);
+                    sums[l] += value;
+                    mins[l] = value < mins[l] ? value : mins[l];
+                    maxs[l] = value > maxs[l] ? value : maxs[l];
+                }
+            }
+            for (size_t i = full; i < n; ++i)
+            {
+                const M value = load(i);
+                sums[0] += value;
+                mins[0] = value < mins[0] ? value : mins[0];
+                maxs[0] = value > maxs[0] ? value : maxs[0];
+            }
+
+            Aggregate result;
+            result.count = n;
+            for (size_t l = 0; l < lanes; ++l)
+            {
+                result.sum += sums[l];
+                result.min = mins[l] < result.min ? mins[l] : result.min;
+                result.max = maxs[l] > result.max ? maxs[l] : result.max;
+            }
+            return result;
+        }
+
+        static void merge(Aggregate &result, const Aggregate &part)
+        {
+            result.count += part.count;
+            result.sum += part.sum;
+            result.min = part.min < result.min ? part.min : result.min;
+            result.max = part.max > result.max ? part.max : result.max;
+        }
+
+#if (defined(__x86_64__) || defined(_M_X64)) && (defined(__GNUC__) || defined(__clang__))
+        static bool gather_supported()
+        {
+            static const bool avx2 = __builtin_cpu_supports("avx2");
+            return (sizeof(M) == 4 || sizeof(M) == 8) && avx2 && stride() * 8 <= static_cast<size_t>(std::numeric_limits<int>::max());
+        }
+
+        /**
+         * @brief Fill the block with the member of n records, gathering 8 (4 bytes members) or 4 (8 bytes members) values per instruction.
+         * 
+         */
+        __attribute__((target("avx2"))) static void gather(const unsigned char *records, size_t n, M *block)
+        {
+            const int step = static_cast<int>(stride());
+            const unsigned char *base = records + offset();
+            size_t i = 0;
+            if constexpr (sizeof(M) == 4)
+            {
+                const __m256i indices = _mm256_mullo_epi32(_mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7), _mm256_set1_epi32(step));
+                for (; i + 8 <= n; i += 8)
+                {
+                    const __m256i values = _mm256_i32gather_epi32(reinterpret_cast<const int *>(base + i * stride()), indices, 1);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(block + i), values);
+                }
+            }
+            else if constexpr (sizeof(M) == 8)
+            {
+                const __m128i indices = _mm_mullo_epi32(_mm_setr_epi32(0, 1, 2, 3), _mm_set1_epi32(step));
+                for (; i + 4 <= n; i += 4)
+                {
+                    const __m256i values = _mm256_i32gather_epi64(reinterpret_cast<const long long *>(base + i * stride()), indices, 1);
+                    _mm256_storeu_si256(reinterpret_cast<__m256i *>(block + i), values);
+                }
+            }
+            for (; i < n; ++i)
+            {
+                block[i] = load_strided(records, i);
+            }
+        }
+#else
+        static bool gather_supported()
+        {
+            return false;
+        }
+
+        static void gather(const unsigned char *records, size_t n, M *block)
+        {
+            for (size_t i = 0; i < n; ++i)
+            {
+                block[i] = load_strided(records, i);
+            }
+        }
+#endif
+    };
+};
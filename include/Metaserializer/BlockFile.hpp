@@ -0,0 +1,712 @@
+#pragma once
+
+#include "../Metaserializer.hpp"
+#include "FileSink.hpp"
+#include "MappedFile.hpp"
+#include "RecordFilter.hpp"
+#include "Records.hpp"
+#include <cmath>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief File of framed records grouped in blocks. Every block has min/max statistics (zone map) of the chosen numeric fields and
+ * a bloom filter of the chosen key fields, computed while writing, so range and point queries skip the blocks which can't match.
+ * 
+ * [block 0 records]...[block n-1 records]
+ * [index: u32 zone field per zone map][u32 key field per bloom filter]
+ *        per block: [u64 offset][u64 size][u32 records][min, max (8 bytes each) per zone map][u32 bloom size, bloom bits per bloom filter]
+ * [trailer: see BlockFileTrailer]
+ */
+namespace Metaserializer
+{
+    struct BlockFileTrailer
+    {
+        std::uint64_t index_offset;
+        std::uint64_t index_size;
+        std::uint32_t block_count;
+        std::uint32_t zone_count;
+        std::uint32_t bloom_count;
+        std::uint32_t version;
+        char magic[4];
+        std::uint32_t reserved;
+
+        static const std::uint32_t current_version = 1;
+    };
+
+    /**
+     * @brief Options of BlockFileWriter.
+     * 
+     */
+    struct BlockFileOptions
+    {
+        size_t block_size = 64 * 1024;  //< Bytes of records after which a block is closed.
+        size_t bloom_bits_per_key = 10; //< About 1% of false positives.
+    };
+
+    /**
+     * @brief Value of a zone map, integers keep all their bits and floating points are stored as double.
+     * 
+     * @tparam T Datatype of the field.
+     */
+    template <typename T>
+    struct ZoneValue
+    {
+        static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "Zone maps need arithmetic or enum fields.");
+
+        using integer_t = typename std::conditional<std::is_enum<T>::value, std::underlying_type<T>, std::enable_if<true, T>>::type::type;
+        using type = typename std::conditional<std::is_floating_point<integer_t>::value, double,
+                                               typename std::conditional<std::is_signed<integer_t>::value, std::int64_t, std::uint64_t>::type>::type;
+
+        static type convert(const T &value)
+        {
+            return static_cast<type>(static_cast<integer_t>(value));
+        }
+
+        static type read(const unsigned char *bytes)
+        {
+            type value;
+            std::memcpy(&value, bytes, sizeof(type));
+            return value;
+        }
+
+        /**
+         * @brief Bounds of a query converted to zone values without truncation: integer fields clamp them to the limits of T
+         * (rounding floating point bounds inwards) and a range out of the limits of T can't match any record.
+         * 
+         * @param min Smallest value of the query.
+         * @param max Biggest value of the query.
+         * @param low Smallest zone value which can match.
+         * @param high Biggest zone value which can match.
+         * @return true Blocks can match, depending on [low, high].
+         * @return false No record can match.
+         */
+        template <typename V>
+        static bool bounds(const V &min, const V &max, type &low, type &high)
+        {
+            if constexpr (std::is_enum<T>::value || std::is_floating_point<T>::value)
+            {
+                low = static_cast<type>(min);
+                high = static_cast<type>(max);
+                return true;
+            }
+            else
+            {
+                static_assert(std::is_arithmetic<V>::value, "Bounds of an integer field must be arithmetic.");
+                const T lowest = std::numeric_limits<T>::lowest(), highest = std::numeric_limits<T>::max();
+                if (less(max, lowest) || less(highest, min))
+                {
+                    return false;
+                }
+                low = less(min, lowest) ? convert(lowest) : inward(min, true);
+                high = less(highest, max) ? convert(highest) : inward(max, false);
+                return true;
+            }
+        }
+
+    private:
+        /**
+         * @brief a < b with the mathematical values, integers of different signedness are not converted.
+         * 
+         */
+        template <typename A, typename B>
+        static bool less(const A &a, const B &b)
+        {
+            if constexpr (std::is_integral<A>::value && std::is_integral<B>::value && std::is_signed<A>::value != std::is_signed<B>::value)
+            {
+                if constexpr (std::is_signed<A>::value)
+                {
+                    return a < 0 || static_cast<typename std::make_unsigned<A>::type>(a) < b;
+                }
+                else
+                {
+                    return b >= 0 && a < static_cast<typename std::make_unsigned<B>::type>(b);
+                }
+            }
+            else if constexpr (std::is_integral<A>::value && std::is_integral<B>::value)
+            {
+                return a < b;
+            }
+            else
+            {
+                return static_cast<long double>(a) < static_cast<long double>(b);
+            }
+        }
+
+        /**
+         * @brief Bound inside the limits of T converted to a zone value, floating points are rounded towards the inside of the range.
+         * 
+         */
+        template <typename V>
+        static type inward(const V &value, bool lower)
+        {
+            if constexpr (std::is_floating_point<V>::value)
+            {
+                return static_cast<type>(lower ? std::ceil(value) : std::floor(value));
+            }
+            else
+            {
+                return static_cast<type>(value);
+            }
+        }
+    };
+
+    /**
+     * @brief Bloom filter of a block, the positions come from one XXH64 of the key (double hashing).
+     * 
+     */
+    struct BlockBloom
+    {
+        static const size_t hashes = 7;
+
+        static std::uint64_t hash(std::string_view key)
+        {
+            return XXHash64::hash(key.data(), key.size());
+        }
+
+        static void add(unsigned char *bits, size_t bit_count, std::uint64_t hash)
+        {
+            const std::uint64_t step = (hash >> 32) | 1;
+            for (size_t i = 0; i < hashes; ++i, hash += step)
+            {
+                const size_t bit = hash % bit_count;
+                bits[bit / 8] |= static_cast<unsigned char>(1u << (bit % 8));
+            }
+        }
+
+        static bool contains(const unsigned char *bits, size_t bit_count, std::uint64_t hash)
+        {
+            const std::uint64_t step = (hash >> 32) | 1;
+            for (size_t i = 0; i < hashes; ++i, hash += step)
+            {
+                const size_t bit = hash % bit_count;
+                if ((bits[bit / 8] & (1u << (bit % 8))) == 0)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief Hash of a key field, strings hash its characters and other datatypes its canonical bytes (see CanonicalObject),
+         * so -0.0 and 0.0 are the same key and every NaN is the same key.
+         * 
+         */
+        template <typename T>
+        static std::uint64_t key_hash(const T &value)
+        {
+            if constexpr (std::is_same<T, std::string>::value || std::is_same<T, std::string_view>::value)
+            {
+                return hash(std::string_view(value));
+            }
+            else
+            {
+                static_assert(std::is_arithmetic<T>::value || std::is_enum<T>::value, "Bloom filters need arithmetic, enum or string fields.");
+                unsigned char bytes[sizeof(T)];
+                CanonicalObject<T>::copy(value, bytes);
+                return hash(std::string_view(reinterpret_cast<const char *>(bytes), sizeof(T)));
+            }
+        }
+    };
+
+    /**
+     * @brief Writer of a block file, every record has the datatypes TArgs.
+     * 
+     * @tparam TArgs Datatypes of every record.
+     */
+    template <typename... TArgs>
+    class BlockFileWriter
+    {
+    public:
+        template <size_t I>
+        using field_t = typename std::tuple_element<I, std::tuple<TArgs...>>::type;
+
+        /**
+         * @brief Create (or truncate) the file.
+         * 
+         * @param path Path of the file.
+         * @param options Block size and bloom filter size.
+         */
+        explicit BlockFileWriter(const std::string &path, BlockFileOptions options = BlockFileOptions())
+            : options(options), fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)), records(0), block_count(0)
+        {
+            if (fd < 0)
+            {
+                throw std::runtime_error("Error while creating block file, can't open " + path + ": " + std::strerror(errno));
+            }
+            sink.reset(new FileSink(fd));
+        }
+
+        BlockFileWriter(const BlockFileWriter &) = delete;
+        BlockFileWriter &operator=(const BlockFileWriter &) = delete;
+
+        /**
+         * @brief The file is completed, errors can't be reported here so call close before destroying the writer.
+         * 
+         */
+        ~BlockFileWriter()
+        {
+            try
+            {
+                close();
+            }
+            catch (...)
+            {
+            }
+        }
+
+        /**
+         * @brief Keep min/max statistics of the field I in every block, it must be called before the first record.
+         * 
+         * @tparam I Index of an arithmetic or enum field.
+         * @return BlockFileWriter& The writer.
+         */
+        template <size_t I>
+        BlockFileWriter &zone_map()
+        {
+            check_empty();
+            using Z = ZoneValue<field_t<I>>;
+            zone_fields.push_back(I);
+            zone_updates.push_back([](unsigned char *stats, bool first, const std::tuple<TArgs &...> &record) {
+                const typename Z::type value = Z::convert(std::get<I>(record));
+                typename Z::type min = first ? value : Z::read(stats), max = first ? value : Z::read(stats + 8);
+                min = value < min ? value : min;
+                max = value > max ? value : max;
+                std::memcpy(stats, &min, sizeof(min));
+                std::memcpy(stats + 8, &max, sizeof(max));
+            });
+            return *this;
+        }
+
+        /**
+         * @brief Keep a bloom filter of the field I in every block, it must be called before the first record.
+         * 
+         * @tparam I Index of an arithmetic, enum or string field.
+         * @return BlockFileWriter& The writer.
+         */
+        template <size_t I>
+        BlockFileWriter &bloom_filter()
+        {
+            check_empty();
+            bloom_fields.push_back(I);
+            bloom_keys.push_back([](const std::tuple<TArgs &...> &record) { return BlockBloom::key_hash(std::get<I>(record)); });
+            return *this;
+        }
+
+        /**
+         * @brief Write one record.
+         * 
+         * @param args Objects of the record.
+         */
+        void append(TArgs &...args)
+        {
+            if (fd < 0)
+            {
+                throw std::runtime_error("Error while writing block file, the file is closed.");
+            }
+            const std::tuple<TArgs &...> record(args...);
+            const bool first = block_records == 0;
+            if (first)
+            {
+                zone_stats.assign(zone_fields.size() * 16, 0);
+                for (auto &hashes : key_hashes)
+                {
+                    hashes.clear();
+                }
+                key_hashes.resize(bloom_fields.size());
+            }
+            for (size_t z = 0; z < zone_updates.size(); ++z)
+            {
+                zone_updates[z](&zone_stats[z * 16], first, record);
+            }
+            for (size_t b = 0; b < bloom_keys.size(); ++b)
+            {
+                key_hashes[b].push_back(bloom_keys[b](record));
+            }
+            StringSink block_sink(block);
+            RecordWriter::append(block_sink, args...);
+            ++block_records;
+            ++records;
+            if (block.size() >= options.block_size)
+            {
+                flush_block();
+            }
+        }
+
+        /**
+         * @brief Write the last block and the index.
+         * 
+         */
+        void close()
+        {
+            if (fd < 0)
+            {
+                return;
+            }
+            try
+            {
+                flush_block();
+                BlockFileTrailer trailer = {};
+                trailer.index_offset = sink->bytes_written();
+                std::string header;
+                for (std::uint32_t field : zone_fields)
+                {
+                    header.append(reinterpret_cast<const char *>(&field), sizeof(field));
+                }
+                for (std::uint32_t field : bloom_fields)
+                {
+                    header.append(reinterpret_cast<const char *>(&field), sizeof(field));
+                }
+                write(header);
+                write(index);
+                trailer.index_size = sink->bytes_written() - trailer.index_offset;
+                trailer.block_count = block_count;
+                trailer.zone_count = static_cast<std::uint32_t>(zone_fields.size());
+                trailer.bloom_count = static_cast<std::uint32_t>(bloom_fields.size());
+                trailer.version = BlockFileTrailer::current_version;
+                std::memcpy(trailer.magic, "MSBF", 4);
+                write(std::string_view(reinterpret_cast<const char *>(&trailer), sizeof(trailer)));
+                sink->flush();
+            }
+            catch (...)
+            {
+                sink.reset();
+                ::close(fd);
+                fd = -1;
+                throw;
+            }
+            sink.reset();
+            const int result = ::close(fd);
+            fd = -1;
+            if (result != 0)
+            {
+                throw std::runtime_error(std::string("Error while closing block file: ") + std::strerror(errno));
+            }
+        }
+
+        /**
+         * @brief Number of records written.
+         * 
+         */
+        size_t size() const
+        {
+            return records;
+        }
+
+    private:
+        BlockFileOptions options;
+        int fd;
+        std::unique_ptr<FileSink> sink;
+        size_t records;
+        std::string block;
+        size_t block_records = 0;
+        std::uint32_t block_count;
+        std::string index;
+        std::vector<std::uint32_t> zone_fields, bloom_fields;
+        std::vector<void (*)(unsigned char *, bool, const std::tuple<TArgs &...> &)> zone_updates;
+        std::vector<std::uint64_t (*)(const std::tuple<TArgs &...> &)> bloom_keys;
+        std::vector<unsigned char> zone_stats;
+        std::vector<std::vector<std::uint64_t>> key_hashes;
+
+        void check_empty() const
+        {
+            if (records > 0)
+            {
+                throw std::runtime_error("Error while configuring block file, records were already written.");
+            }
+        }
+
+        void write(std::string_view bytes)
+        {
+            std::memcpy(sink->reserve(bytes.size()), bytes.data(), bytes.size());
+            sink->commit(bytes.size());
+        }
+
+        void flush_block()
+        {
+            if (block_records == 0)
+            {
+                return;
+            }
+            const std::uint64_t entry[2] = {sink->bytes_written(), block.size()};
+            const std::uint32_t count = static_cast<std::uint32_t>(block_records);
+            write(block);
+            index.append(reinterpret_cast<const char *>(entry), sizeof(entry));
+            index.append(reinterpret_cast<const char *>(&count), sizeof(count));
+            index.append(reinterpret_cast<const char *>(zone_stats.data()), zone_stats.size());
+            for (const auto &hashes : key_hashes)
+            {
+                const std::uint32_t bits = static_cast<std::uint32_t>((std::max<size_t>(64, hashes.size() * options.bloom_bits_per_key) + 63) / 64 * 64);
+                std::string bloom(bits / 8, '\0');
+                for (std::uint64_t hash : hashes)
+                {
+                    BlockBloom::add(reinterpret_cast<unsigned char *>(&bloom[0]), bits, hash);
+                }
+                const std::uint32_t bytes = bits / 8;
+                index.append(reinterpret_cast<const char *>(&bytes), sizeof(bytes));
+                index += bloom;
+            }
+            block.clear();
+            block_records = 0;
+            ++block_count;
+        }
+    };
+
+    /**
+     * @brief Reader of a block file, the file is memory mapped and the records are views into the mapping.
+     * 
+     * @tparam TArgs Datatypes of every record.
+     */
+    template <typename... TArgs>
+    class BlockFileReader
+    {
+    public:
+        template <size_t I>
+        using field_t = typename std::tuple_element<I, std::tuple<TArgs...>>::type;
+
+        /**
+         * @brief Block of the file with its statistics.
+         * 
+         */
+        struct Block
+        {
+            std::string_view records;
+            std::uint32_t count;
+            const unsigned char *zones; //< min and max per zone map.
+            std::vector<std::string_view> blooms;
+        };
+
+        /**
+         * @brief Query over the blocks: every predicate skips the blocks whose statistics can't match and checks the records
+         * of the other blocks (see RecordFilter).
+         * 
+         */
+        class Query
+        {
+        public:
+            explicit Query(const BlockFileReader &reader) : reader(reader), blocks_read(0) {}
+
+            /**
+             * @brief Keep the records where the field I is in [min, max].
+             * 
+             */
+            template <size_t I, typename V>
+            Query &range(const V &min, const V &max)
+            {
+                filter.template range<I>(min, max);
+                skip_by_zone<I>(min, max);
+                return *this;
+            }
+
+            /**
+             * @brief Keep the records where the field I is equal to the value, strings are given as std::string_view.
+             * 
+             */
+            template <size_t I, typename V>
+            Query &equal(const V &value)
+            {
+                filter.template equal<I>(value);
+                if constexpr (std::is_arithmetic<field_t<I>>::value || std::is_enum<field_t<I>>::value)
+                {
+                    skip_by_zone<I>(value, value);
+                }
+                const int bloom = reader.bloom_slot(I);
+                if (bloom >= 0)
+                {
+                    using K = typename std::conditional<std::is_same<field_t<I>, std::string>::value, std::string_view, field_t<I>>::type;
+                    const K key = value;
+                    const std::uint64_t hash = BlockBloom::key_hash(key);
+                    block_predicates.push_back([bloom, hash](const Block &block) {
+                        const std::string_view bits = block.blooms[bloom];
+                        return BlockBloom::contains(reinterpret_cast<const unsigned char *>(bits.data()), bits.size() * 8, hash);
+                    });
+                }
+                return *this;
+            }
+
+            /**
+             * @brief Call the function with every record which matches.
+             * 
+             * @tparam F Datatype of the function, called as f(std::string_view record).
+             * @param f Function called with the bytes of every record, they can be decoded with Unserialize<>::apply.
+             * @return size_t Number of records which match.
+             */
+            template <typename F>
+            size_t for_each(F &&f)
+            {
+                size_t count = 0;
+                blocks_read = 0;
+                for (const Block &block : reader.blocks)
+                {
+                    bool candidate = true;
+                    for (const auto &predicate : block_predicates)
+                    {
+                        if (!predicate(block))
+                        {
+                            candidate = false;
+                            break;
+                        }
+                    }
+                    if (candidate)
+                    {
+                        ++blocks_read;
+                        count += filter.for_each(block.records, f);
+                    }
+                }
+                return count;
+            }
+
+            /**
+             * @brief Number of blocks read by the last for_each, the rest were skipped by its statistics.
+             * 
+             */
+            size_t blocks_scanned() const
+            {
+                return blocks_read;
+            }
+
+        private:
+            const BlockFileReader &reader;
+            RecordFilter<TArgs...> filter;
+            std::vector<std::function<bool(const Block &)>> block_predicates;
+            size_t blocks_read;
+
+            /**
+             * @brief Skip the blocks whose zone map of the field I does not overlap [min, max].
+             * 
+             */
+            template <size_t I, typename V>
+            void skip_by_zone(const V &min, const V &max)
+            {
+                const int zone = reader.zone_slot(I);
+                if (zone >= 0)
+                {
+                    using Z = ZoneValue<field_t<I>>;
+                    typename Z::type low, high;
+                    if (!Z::bounds(min, max, low, high))
+                    {
+                        block_predicates.push_back([](const Block &) { return false; });
+                        return;
+                    }
+                    block_predicates.push_back([zone, low, high](const Block &block) {
+                        return !(Z::read(block.zones + zone * 16) > high) && !(Z::read(block.zones + zone * 16 + 8) < low);
+                    });
+                }
+            }
+        };
+
+        /**
+         * @brief Map the file and read its index.
+         * 
+         * @param path Path of the file.
+         */
+        explicit BlockFileReader(const std::string &path) : file(MappedFile::open(path))
+        {
+            const unsigned char *bytes = file.data();
+            BlockFileTrailer trailer;
+            if (file.size() < sizeof(trailer))
+            {
+                throw std::runtime_error("Error while opening block file, " + path + " is too small.");
+            }
+            std::memcpy(&trailer, bytes + file.size() - sizeof(trailer), sizeof(trailer));
+            if (std::memcmp(trailer.magic, "MSBF", 4) != 0 || trailer.version != BlockFileTrailer::current_version)
+            {
+                throw std::runtime_error("Error while opening block file, " + path + " is not a block file.");
+            }
+            if (trailer.index_offset > file.size() - sizeof(trailer) || trailer.index_size > file.size() - sizeof(trailer) - trailer.index_offset)
+            {
+                throw std::runtime_error("Error while opening block file, index out of the file.");
+            }
+
+            const unsigned char *it = bytes + trailer.index_offset;
+            const unsigned char *end = it + trailer.index_size;
+            auto read = [&it, end](void *dest, size_t size) {
+                if (static_cast<size_t>(end - it) < size)
+                {
+                    throw std::runtime_error("Error while opening block file, truncated index.");
+                }
+                std::memcpy(dest, it, size);
+                it += size;
+            };
+            zone_fields.resize(trailer.zone_count);
+            bloom_fields.resize(trailer.bloom_count);
+            for (auto &field : zone_fields)
+            {
+                read(&field, sizeof(field));
+            }
+            for (auto &field : bloom_fields)
+            {
+                read(&field, sizeof(field));
+            }
+            blocks.resize(trailer.block_count);
+            for (Block &block : blocks)
+            {
+                std::uint64_t entry[2];
+                read(entry, sizeof(entry));
+                read(&block.count, sizeof(block.count));
+                if (entry[0] > trailer.index_offset || entry[1] > trailer.index_offset - entry[0])
+                {
+                    throw std::runtime_error("Error while opening block file, block out of the file.");
+                }
+                block.records = std::string_view(reinterpret_cast<const char *>(bytes + entry[0]), entry[1]);
+                block.zones = it;
+                if (static_cast<size_t>(end - it) < zone_fields.size() * 16)
+                {
+                    throw std::runtime_error("Error while opening block file, truncated index.");
+                }
+                it += zone_fields.size() * 16;
+                for (size_t b = 0; b < bloom_fields.size(); ++b)
+                {
+                    std::uint32_t size;
+                    read(&size, sizeof(size));
+                    if (static_cast<size_t>(end - it) < size || size == 0)
+                    {
+                        throw std::runtime_error("Error while opening block file, truncated index.");
+                    }
+                    block.blooms.emplace_back(reinterpret_cast<const char *>(it), size);
+                    it += size;
+                }
+            }
+        }
+
+        Query query() const
+        {
+            return Query(*this);
+        }
+
+        const std::vector<Block> &block_list() const
+        {
+            return blocks;
+        }
+
+    private:
+        MappedFile file;
+        std::vector<std::uint32_t> zone_fields, bloom_fields;
+        std::vector<Block> blocks;
+
+        int zone_slot(size_t field) const
+        {
+            for (size_t i = 0; i < zone_fields.size(); ++i)
+            {
+                if (zone_fields[i] == field)
+                {
+                    return static_cast<int>(i);
+                }
+            }
+            return -1;
+        }
+
+        int bloom_slot(size_t field) const
+        {
+            for (size_t i = 0; i < bloom_fields.size(); ++i)
+            {
+                if (bloom_fields[i] == field)
+                {
+                    return static_cast<int>(i);
+                }
+            }
+            return -1;
+        }
+    };
+};
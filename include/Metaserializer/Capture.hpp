@@ -0,0 +1,430 @@
+#pragma once
+
+#include "../Metaserializer.hpp"
+#include "FileSink.hpp"
+#include "MappedFile.hpp"
+#include "Records.hpp"
+#include <chrono>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief Capture of a message stream: every record is stored with its arrival timestamp and a sparse index of (timestamp, offset)
+ * is written every index_interval records, so a replay seeks to a timestamp with a binary search and at most index_interval reads.
+ * 
+ * [u64 timestamp][u32 size][record bytes]... timestamps are nanoseconds since the epoch and never decrease
+ * [index: u64 timestamp, u64 offset per indexed record]
+ * [trailer: see CaptureTrailer]
+ */
+namespace Metaserializer
+{
+    struct CaptureTrailer
+    {
+        std::uint64_t index_offset;
+        std::uint64_t index_count;
+        std::uint64_t record_count;
+        std::uint64_t first_timestamp;
+        std::uint64_t last_timestamp;
+        std::uint32_t version;
+        char magic[4];
+
+        static const std::uint32_t current_version = 1;
+    };
+
+    /**
+     * @brief Writer of a capture file.
+     * 
+     */
+    class CaptureWriter
+    {
+    public:
+        /**
+         * @brief Create (or truncate) the file.
+         * 
+         * @param path Path of the file.
+         * @param index_interval Records between two entries of the index.
+         */
+        explicit CaptureWriter(const std::string &path, size_t index_interval = 1024)
+            : fd(::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644)), interval(index_interval > 0 ? index_interval : 1), records(0),
+              first(0), last(0)
+        {
+            if (fd < 0)
+            {
+                throw std::runtime_error("Error while creating capture, can't open " + path + ": " + std::strerror(errno));
+            }
+            sink.reset(new FileSink(fd));
+        }
+
+        CaptureWriter(const CaptureWriter &) = delete;
+        CaptureWriter &operator=(const CaptureWriter &) = delete;
+
+        /**
+         * @brief The file is completed, errors can't be reported here so call close before destroying the writer.
+         * 
+         */
+        ~CaptureWriter()
+        {
+            try
+            {
+                close();
+            }
+            catch (...)
+            {
+            }
+        }
+
+        /**
+         * @brief Current time in nanoseconds since the epoch.
+         * 
+         */
+        static std::uint64_t now()
+        {
+            return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::system_clock::now().time_since_epoch()).count());
+        }
+
+        /**
+         * @brief Write one record with the current time, a clock going back in time gives the timestamp of the previous record.
+         * 
+         * @param args Objects serialized in the record.
+         */
+        template <typename... TArgs>
+        void append(TArgs &...args)
+        {
+            const std::uint64_t timestamp = now();
+            append_at(records > 0 && timestamp < last ? last : timestamp, args...);
+        }
+
+        /**
+         * @brief Write one record with the timestamp given, it can't be before the timestamp of the previous record.
+         * 
+         * @param timestamp Arrival time in nanoseconds since the epoch.
+         * @param args Objects serialized in the record.
+         */
+        template <typename... TArgs>
+        void append_at(std::uint64_t timestamp, TArgs &...args)
+        {
+            if (fd < 0)
+            {
+                throw std::runtime_error("Error while writing capture, the file is closed.");
+            }
+            if (records > 0 && timestamp < last)
+            {
+                throw std::runtime_error("Error while writing capture, timestamps must not decrease.");
+            }
+            const std::uint64_t offset = sink->bytes_written();
+            if (records % interval == 0)
+            {
+                const std::uint64_t entry[2] = {timestamp, offset};
+                index.append(reinterpret_cast<const char *>(entry), sizeof(entry));
+            }
+            std::memcpy(sink->reserve(sizeof(timestamp)), &timestamp, sizeof(timestamp));
+            sink->commit(sizeof(timestamp));
+            RecordWriter::append(*sink, args...);
+            first = records == 0 ? timestamp : first;
+            last = timestamp;
+            ++records;
+        }
+
+        /**
+         * @brief Write the index and the trailer.
+         * 
+         */
+        void close()
+        {
+            if (fd < 0)
+            {
+                return;
+            }
+            try
+            {
+                CaptureTrailer trailer = {};
+                trailer.index_offset = sink->bytes_written();
+                trailer.index_count = index.size() / 16;
+                trailer.record_count = records;
+                trailer.first_timestamp = first;
+                trailer.last_timestamp = last;
+                trailer.version = CaptureTrailer::current_version;
+                std::memcpy(trailer.magic, "MSCP", 4);
+                write(index);
+                write(std::string_view(reinterpret_cast<const char *>(&trailer), sizeof(trailer)));
+                sink->flush();
+            }
+            catch (...)
+            {
+                sink.reset();
+                ::close(fd);
+                fd = -1;
+                throw;
+            }
+            sink.reset();
+            const int result = ::close(fd);
+            fd = -1;
+            if (result != 0)
+            {
+                throw std::runtime_error(std::string("Error while closing capture: ") + std::strerror(errno));
+            }
+        }
+
+        /**
+         * @brief Number of records written.
+         * 
+         */
+        size_t size() const
+        {
+            return records;
+        }
+
+    private:
+        int fd;
+        std::unique_ptr<FileSink> sink;
+        size_t interval;
+        size_t records;
+        std::uint64_t first, last;
+        std::string index;
+
+        void write(std::string_view bytes)
+        {
+            std::memcpy(sink->reserve(bytes.size()), bytes.data(), bytes.size());
+            sink->commit(bytes.size());
+        }
+    };
+
+    /**
+     * @brief Reader of a capture file, the file is memory mapped and the records are views into it. A file without trailer (the
+     * writer did not close it) is read up to its last complete record, its index is rebuilt with one scan.
+     * 
+     */
+    class CaptureReader
+    {
+    public:
+        /**
+         * @brief Record of the capture.
+         * 
+         */
+        struct Entry
+        {
+            std::uint64_t timestamp;
+            std::string_view record; //< Bytes of the record, decoded with Unserialize<>::apply.
+        };
+
+        /**
+         * @brief Position in the records of the capture.
+         * 
+         */
+        class Cursor
+        {
+        public:
+            /**
+             * @brief Get the next record.
+             * 
+             * @param entry Timestamp and bytes of the record.
+             * @return true There was a record.
+             * @return false End of the capture.
+             */
+            bool next(Entry &entry)
+            {
+                const size_t header = sizeof(std::uint64_t) + sizeof(record_size_t);
+                if (position == records.size())
+                {
+                    return false;
+                }
+                if (records.size() - position < header)
+                {
+                    throw std::runtime_error("Error while reading capture, truncated record.");
+                }
+                record_size_t size;
+                std::memcpy(&entry.timestamp, records.data() + position, sizeof(std::uint64_t));
+                std::memcpy(&size, records.data() + position + sizeof(std::uint64_t), sizeof(record_size_t));
+                if (records.size() - position - header < size)
+                {
+                    throw std::runtime_error("Error while reading capture, truncated record.");
+                }
+                entry.record = records.substr(position + header, size);
+                position += header + size;
+                return true;
+            }
+
+            /**
+             * @brief Offset of the next record in the file.
+             * 
+             */
+            size_t offset() const
+            {
+                return position;
+            }
+
+        private:
+            friend class CaptureReader;
+
+            Cursor(std::string_view records, size_t position) : records(records), position(position) {}
+
+            std::string_view records;
+            size_t position;
+        };
+
+        /**
+         * @brief Map the file and read its index.
+         * 
+         * @param path Path of the file.
+         */
+        explicit CaptureReader(const std::string &path) : file(MappedFile::open(path)), count(0), first(0), last(0)
+        {
+            const unsigned char *bytes = file.data();
+            CaptureTrailer trailer;
+            if (file.size() >= sizeof(trailer))
+            {
+                std::memcpy(&trailer, bytes + file.size() - sizeof(trailer), sizeof(trailer));
+            }
+            if (file.size() < sizeof(trailer) || std::memcmp(trailer.magic, "MSCP", 4) != 0)
+            {
+                recover();
+                return;
+            }
+            if (trailer.version != CaptureTrailer::current_version)
+            {
+                throw std::runtime_error("Error while opening capture, unknown version of " + path + ".");
+            }
+            if (trailer.index_offset > file.size() - sizeof(trailer) || trailer.index_count > (file.size() - sizeof(trailer) - trailer.index_offset) / 16)
+            {
+                throw std::runtime_error("Error while opening capture, index out of the file.");
+            }
+            records = std::string_view(reinterpret_cast<const char *>(bytes), trailer.index_offset);
+            index.resize(trailer.index_count);
+            if (!index.empty())
+            {
+                std::memcpy(index.data(), bytes + trailer.index_offset, index.size() * sizeof(IndexEntry));
+            }
+            count = trailer.record_count;
+            first = trailer.first_timestamp;
+            last = trailer.last_timestamp;
+        }
+
+        /**
+         * @brief Cursor at the first record.
+         * 
+         */
+        Cursor begin() const
+        {
+            return Cursor(records, 0);
+        }
+
+        /**
+         * @brief Cursor at the first record whose timestamp is at or after the one given, found with a binary search in the index
+         * and a scan of at most index_interval records.
+         * 
+         * @param timestamp Nanoseconds since the epoch.
+         * @return Cursor Position of the record (the end when every record is before).
+         */
+        Cursor seek(std::uint64_t timestamp) const
+        {
+            const auto found = std::lower_bound(index.begin(), index.end(), timestamp,
+                                                [](const IndexEntry &entry, std::uint64_t value) { return entry.timestamp < value; });
+            Cursor cursor(records, found == index.begin() ? 0 : static_cast<size_t>((found - 1)->offset));
+            Cursor ahead = cursor;
+            Entry entry;
+            while (ahead.next(entry) && entry.timestamp < timestamp)
+            {
+                cursor = ahead;
+            }
+            return cursor;
+        }
+
+        /**
+         * @brief Call the function with the records whose timestamp is in [from, to), waiting between them as in the capture.
+         * 
+         * @tparam F Datatype of the function, called as f(const Entry&).
+         * @param from First timestamp replayed.
+         * @param to Timestamp where the replay stops.
+         * @param speed 1 replays at the original pacing, 2 twice faster..., 0 (or less) as fast as possible.
+         * @param f Function called with every record.
+         * @return size_t Number of records replayed.
+         */
+        template <typename F>
+        size_t replay(std::uint64_t from, std::uint64_t to, double speed, F &&f) const
+        {
+            Cursor cursor = seek(from);
+            Entry entry;
+            size_t replayed = 0;
+            const auto start = std::chrono::steady_clock::now();
+            std::uint64_t base = 0;
+            while (cursor.next(entry) && entry.timestamp < to)
+            {
+                if (speed > 0)
+                {
+                    base = replayed == 0 ? entry.timestamp : base;
+                    const auto delay = std::chrono::nanoseconds(static_cast<std::int64_t>(static_cast<double>(entry.timestamp - base) / speed));
+                    std::this_thread::sleep_until(start + delay);
+                }
+                f(static_cast<const Entry &>(entry));
+                ++replayed;
+            }
+            return replayed;
+        }
+
+        /**
+         * @brief Number of records.
+         * 
+         */
+        size_t size() const
+        {
+            return count;
+        }
+
+        std::uint64_t first_timestamp() const
+        {
+            return first;
+        }
+
+        std::uint64_t last_timestamp() const
+        {
+            return last;
+        }
+
+    private:
+        struct IndexEntry
+        {
+            std::uint64_t timestamp;
+            std::uint64_t offset;
+        };
+
+        MappedFile file;
+        std::string_view records;
+        std::vector<IndexEntry> index;
+        size_t count;
+        std::uint64_t first, last;
+
+        /**
+         * @brief Keep the complete records of a capture which was not closed and index every 1024 of them.
+         * 
+         */
+        void recover()
+        {
+            const std::string_view bytes(reinterpret_cast<const char *>(file.data()), file.size());
+            Cursor cursor(bytes, 0);
+            Entry entry;
+            size_t end = 0;
+            try
+            {
+                while (cursor.next(entry))
+                {
+                    if (count > 0 && entry.timestamp < last)
+                    {
+                        break;
+                    }
+                    if (count % 1024 == 0)
+                    {
+                        index.push_back(IndexEntry{entry.timestamp, end});
+                    }
+                    first = count == 0 ? entry.timestamp : first;
+                    last = entry.timestamp;
+                    ++count;
+                    end = cursor.offset();
+                }
+            }
+            catch (const std::runtime_error &)
+            {
+            }
+            records = bytes.substr(0, end);
+        }
+    };
+};
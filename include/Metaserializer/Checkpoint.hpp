@@ -0,0 +1,251 @@
+#pragma once
+
+#include "../Metaserializer.hpp"
+#include "Snapshot.hpp"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace Metaserializer
+{
+    /**
+     * @brief Result of a background checkpoint.
+     * 
+     */
+    struct CheckpointResult
+    {
+        bool success = false;
+        size_t bytes = 0;  //< Bytes written by the child.
+        std::string error; //< Error reported by the child when it failed.
+    };
+
+    /**
+     * @brief Checkpoint written by a forked child process (POSIX). The child gets a copy on write view of the whole memory
+     * at the moment of the fork, so the caller only pays for the fork (copying the page tables) and keeps modifying its state
+     * while the child serializes the view to disk and reports the result through a pipe.
+     * Only the thread calling start exists in the child: the function run there must not wait for locks other threads can hold.
+     * 
+     */
+    class BackgroundCheckpoint
+    {
+    public:
+        BackgroundCheckpoint() : child(-1), pipe_fd(-1) {}
+
+        BackgroundCheckpoint(const BackgroundCheckpoint &) = delete;
+        BackgroundCheckpoint &operator=(const BackgroundCheckpoint &) = delete;
+
+        /**
+         * @brief A running checkpoint is waited so the child is not left as a zombie.
+         * 
+         */
+        ~BackgroundCheckpoint()
+        {
+            if (running())
+            {
+                wait();
+            }
+        }
+
+        /**
+         * @brief Fork and save the snapshot in the child.
+         * 
+         * @param snapshot Roots to be saved, they are read by the child as they were at the moment of the fork.
+         * @param path Path of the snapshot file.
+         */
+        void start(const Snapshot &snapshot, const std::string &path)
+        {
+            start([&snapshot, &path]() { return snapshot.save(path); });
+        }
+
+        /**
+         * @brief Fork and run the function in the child, it must return the number of bytes written or throw.
+         * 
+         * @tparam F Datatype of the function.
+         * @param save Function which writes the checkpoint.
+         */
+        template <typename F>
+        void start(F &&save)
+        {
+            if (running())
+            {
+                throw std::runtime_error("Error while starting checkpoint, the previous one is still running.");
+            }
+            int fds[2];
+            if (::pipe2(fds, O_CLOEXEC) != 0)
+            {
+                throw std::runtime_error(std::string("Error while starting checkpoint, can't create pipe: ") + std::strerror(errno));
+            }
+
+            const pid_t pid = ::fork();
+            if (pid < 0)
+            {
+                const int error = errno;
+                ::close(fds[0]);
+                ::close(fds[1]);
+                throw std::runtime_error(std::string("Error while starting checkpoint, can't fork: ") + std::strerror(error));
+            }
+            if (pid == 0)
+            {
+                ::close(fds[0]);
+                run_child(fds[1], save);
+            }
+
+            ::close(fds[1]);
+            child = pid;
+            pipe_fd = fds[0];
+            result = CheckpointResult();
+        }
+
+        bool running() const
+        {
+            return child > 0;
+        }
+
+        /**
+         * @brief Check without blocking if the checkpoint finished.
+         * 
+         * @return true The checkpoint finished, its result is in last_result().
+         * @return false The checkpoint is still running.
+         */
+        bool poll()
+        {
+            return running() && finish(WNOHANG);
+        }
+
+        /**
+         * @brief Block until the checkpoint finishes.
+         * 
+         * @return const CheckpointResult& Result of the checkpoint.
+         */
+        const CheckpointResult &wait()
+        {
+            if (running())
+            {
+                finish(0);
+            }
+            return result;
+        }
+
+        /**
+         * @brief Result of the last finished checkpoint.
+         * 
+         * @return const CheckpointResult& Result of the checkpoint.
+         */
+        const CheckpointResult &last_result() const
+        {
+            return result;
+        }
+
+    private:
+        pid_t child;
+        int pipe_fd;
+        CheckpointResult result;
+
+        /**
+         * @brief Body of the child: the report is [u64 bytes][u8 success][error message] and the child exits without running
+         * destructors or atexit handlers of the parent state.
+         * 
+         */
+        template <typename F>
+        [[noreturn]] static void run_child(int fd, F &save)
+        {
+            std::uint64_t bytes = 0;
+            unsigned char success = 1;
+            std::string error;
+            try
+            {
+                bytes = save();
+            }
+            catch (const std::exception &exception)
+            {
+                success = 0;
+                error = exception.what();
+            }
+            catch (...)
+            {
+                success = 0;
+                error = "Unknown error.";
+            }
+
+            std::string report(sizeof(bytes) + 1, '\0');
+            std::memcpy(&report[0], &bytes, sizeof(bytes));
+            report[sizeof(bytes)] = static_cast<char>(success);
+            report += error;
+            size_t offset = 0;
+            while (offset < report.size())
+            {
+                const ssize_t written = ::write(fd, report.data() + offset, report.size() - offset);
+                if (written < 0 && errno == EINTR)
+                {
+                    continue;
+                }
+                if (written <= 0)
+                {
+                    break;
+                }
+                offset += static_cast<size_t>(written);
+            }
+            ::_exit(success ? 0 : 1);
+        }
+
+        bool finish(int options)
+        {
+            int status = 0;
+            pid_t pid;
+            do
+            {
+                pid = ::waitpid(child, &status, options);
+            } while (pid < 0 && errno == EINTR);
+            const int wait_error = errno;
+            if (pid == 0)
+            {
+                return false;
+            }
+
+            std::string report;
+            char chunk[256];
+            ssize_t bytes;
+            while ((bytes = ::read(pipe_fd, chunk, sizeof(chunk))) != 0)
+            {
+                if (bytes < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    break;
+                }
+                report.append(chunk, static_cast<size_t>(bytes));
+            }
+            ::close(pipe_fd);
+            pipe_fd = -1;
+            child = -1;
+
+            result = CheckpointResult();
+            if (report.size() > sizeof(std::uint64_t))
+            {
+                std::uint64_t written;
+                std::memcpy(&written, report.data(), sizeof(written));
+                result.bytes = written;
+                result.success = report[sizeof(written)] != 0;
+                result.error = report.substr(sizeof(written) + 1);
+            }
+            if (pid < 0)
+            {
+                result.success = false;
+                result.error = std::string("Can't wait the checkpoint process: ") + std::strerror(wait_error);
+            }
+            else if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+            {
+                result.success = false;
+                if (result.error.empty())
+                {
+                    result.error = WIFSIGNALED(status) ? "Checkpoint process killed by signal " + std::to_string(WTERMSIG(status)) + "." : "Checkpoint process failed.";
+                }
+            }
+            return true;
+        }
+    };
+};
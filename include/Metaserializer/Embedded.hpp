@@ -0,0 +1,346 @@
+#pragma once
+
+#include "../Metaserializer.hpp"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#if __cplusplus > 201703L && __has_include(<bit>)
+#include <bit>
+#endif
+
+/**
+ * @brief Serialization evaluated by the compiler: literal values are written to a std::array<std::byte, N> which can be declared
+ * static constexpr, so the data is part of the read only section of the binary and is read in place with no parsing at startup.
+ * 
+ * [u64 fingerprint of the datatypes][fields]
+ * Fields have the same bytes as Serialize<>::apply on a little endian target (std::array as its elements, FixedString as a std::string,
+ * enums with a compact EnumRange in 1 byte), only the first 8 bytes differ because std::type_info can't be used at compile time.
+ */
+namespace Metaserializer
+{
+    /**
+     * @brief String literal usable at compile time, FixedString("text") keeps the characters and the null terminator.
+     * 
+     * @tparam N Size of the literal, including the null terminator.
+     */
+    template <size_t N>
+    struct FixedString
+    {
+        char chars[N] = {};
+
+        constexpr FixedString() = default;
+
+        constexpr FixedString(const char (&text)[N])
+        {
+            for (size_t i = 0; i < N; ++i)
+            {
+                chars[i] = text[i];
+            }
+        }
+
+        static constexpr size_t size()
+        {
+            return N - 1;
+        }
+
+        constexpr std::string_view view() const
+        {
+            return std::string_view(chars, N - 1);
+        }
+    };
+
+    template <typename T>
+    struct IsFixedString : std::false_type
+    {
+    };
+
+    template <size_t N>
+    struct IsFixedString<FixedString<N>> : std::true_type
+    {
+    };
+
+    /**
+     * @brief Compile time writer and reader of a field, specialized for integers, enums, floating points (only with std::bit_cast),
+     * std::array and FixedString. Enums with an EnumRange must be compact (1 byte, see EnumObject), varints would move the next fields.
+     * 
+     * @tparam T Datatype of the field.
+     */
+    template <typename T, typename Enable = void>
+    struct EmbeddedField
+    {
+        static_assert(sizeof(T) == 0, "Datatype can't be serialized at compile time.");
+    };
+
+    template <typename T>
+    struct EmbeddedField<T, typename std::enable_if<std::is_integral<T>::value || (std::is_enum<T>::value && !EnumRange<T>::enabled)>::type>
+    {
+        static constexpr size_t size = sizeof(T);
+
+        template <size_t N>
+        static constexpr void write(std::array<std::byte, N> &out, size_t offset, const T &value)
+        {
+            const std::uint64_t bits = to_bits(value);
+            for (size_t i = 0; i < sizeof(T); ++i)
+            {
+                out[offset + i] = static_cast<std::byte>((bits >> (8 * i)) & 0xff);
+            }
+        }
+
+        template <size_t N>
+        static constexpr T read(const std::array<std::byte, N> &in, size_t offset)
+        {
+            std::uint64_t bits = 0;
+            for (size_t i = 0; i < sizeof(T); ++i)
+            {
+                bits |= static_cast<std::uint64_t>(in[offset + i]) << (8 * i);
+            }
+            return from_bits(bits);
+        }
+
+    private:
+        static constexpr std::uint64_t to_bits(const T &value)
+        {
+            if constexpr (std::is_enum<T>::value)
+            {
+                return static_cast<std::uint64_t>(static_cast<typename std::make_unsigned<typename std::underlying_type<T>::type>::type>(value));
+            }
+            else if constexpr (std::is_same<T, bool>::value)
+            {
+                return value ? 1 : 0;
+            }
+            else
+            {
+                return static_cast<std::uint64_t>(static_cast<typename std::make_unsigned<T>::type>(value));
+            }
+        }
+
+        static constexpr T from_bits(std::uint64_t bits)
+        {
+            if constexpr (std::is_enum<T>::value)
+            {
+                using U = typename std::underlying_type<T>::type;
+                return static_cast<T>(static_cast<U>(static_cast<typename std::make_unsigned<U>::type>(bits)));
+            }
+            else if constexpr (std::is_same<T, bool>::value)
+            {
+                return bits != 0;
+            }
+            else
+            {
+                return static_cast<T>(static_cast<typename std::make_unsigned<T>::type>(bits));
+            }
+        }
+    };
+
+    template <typename T>
+    struct EmbeddedField<T, typename std::enable_if<std::is_enum<T>::value && EnumRange<T>::enabled>::type>
+    {
+        using range = EnumRange<T>;
+        static_assert(range::compact, "Enums written at compile time need a compact EnumRange (less than 256 values apart).");
+        static constexpr size_t size = 1;
+
+        template <size_t N>
+        static constexpr void write(std::array<std::byte, N> &out, size_t offset, const T &value)
+        {
+            if (!range::contains(static_cast<std::int64_t>(value)))
+            {
+                throw std::runtime_error("Error while serializing enum, value is not one of the declared values.");
+            }
+            out[offset] = static_cast<std::byte>(static_cast<std::int64_t>(value) - range::min);
+        }
+
+        template <size_t N>
+        static constexpr T read(const std::array<std::byte, N> &in, size_t offset)
+        {
+            const std::int64_t value = range::min + static_cast<std::int64_t>(in[offset]);
+            if (!range::contains(value))
+            {
+                throw std::runtime_error("Error while unserializing enum, value is not one of the declared values.");
+            }
+            return static_cast<T>(value);
+        }
+    };
+
+#if defined(__cpp_lib_bit_cast)
+    template <typename T>
+    struct EmbeddedField<T, typename std::enable_if<std::is_floating_point<T>::value && (sizeof(T) == 4 || sizeof(T) == 8)>::type>
+    {
+        using bits_t = typename std::conditional<sizeof(T) == 4, std::uint32_t, std::uint64_t>::type;
+        static constexpr size_t size = sizeof(T);
+
+        template <size_t N>
+        static constexpr void write(std::array<std::byte, N> &out, size_t offset, const T &value)
+        {
+            EmbeddedField<bits_t>::write(out, offset, std::bit_cast<bits_t>(value));
+        }
+
+        template <size_t N>
+        static constexpr T read(const std::array<std::byte, N> &in, size_t offset)
+        {
+            return std::bit_cast<T>(EmbeddedField<bits_t>::read(in, offset));
+        }
+    };
+#endif
+
+    template <typename T, size_t M>
+    struct EmbeddedField<std::array<T, M>>
+    {
+        static constexpr size_t size = M * EmbeddedField<T>::size;
+
+        template <size_t N>
+        static constexpr void write(std::array<std::byte, N> &out, size_t offset, const std::array<T, M> &value)
+        {
+            for (size_t i = 0; i < M; ++i)
+            {
+                EmbeddedField<T>::write(out, offset + i * EmbeddedField<T>::size, value[i]);
+            }
+        }
+
+        template <size_t N>
+        static constexpr std::array<T, M> read(const std::array<std::byte, N> &in, size_t offset)
+        {
+            std::array<T, M> value = {};
+            for (size_t i = 0; i < M; ++i)
+            {
+                value[i] = EmbeddedField<T>::read(in, offset + i * EmbeddedField<T>::size);
+            }
+            return value;
+        }
+    };
+
+    template <size_t M>
+    struct EmbeddedField<FixedString<M>>
+    {
+        static_assert(M - 1 <= static_cast<size_t>(std::numeric_limits<serial_size_t>::max()), "String size does not fit in serial_size_t.");
+        static constexpr size_t size = sizeof(serial_size_t) + M - 1;
+
+        template <size_t N>
+        static constexpr void write(std::array<std::byte, N> &out, size_t offset, const FixedString<M> &value)
+        {
+            EmbeddedField<serial_size_t>::write(out, offset, static_cast<serial_size_t>(M - 1));
+            for (size_t i = 0; i + 1 < M; ++i)
+            {
+                out[offset + sizeof(serial_size_t) + i] = static_cast<std::byte>(value.chars[i]);
+            }
+        }
+
+        template <size_t N>
+        static constexpr FixedString<M> read(const std::array<std::byte, N> &in, size_t offset)
+        {
+            FixedString<M> value;
+            for (size_t i = 0; i + 1 < M; ++i)
+            {
+                value.chars[i] = static_cast<char>(in[offset + sizeof(serial_size_t) + i]);
+            }
+            return value;
+        }
+    };
+
+    /**
+     * @brief Serialize literal values at compile time.
+     * 
+     */
+    struct EmbeddedSerialize
+    {
+        /**
+         * @brief Number of bytes of the serialized values.
+         * 
+         * @tparam Ts Datatypes serialized.
+         */
+        template <typename... Ts>
+        static constexpr size_t size = sizeof(std::uint64_t) + (size_t(0) + ... + EmbeddedField<Ts>::size);
+
+        /**
+         * @brief Serialize the values, the result can be declared static constexpr.
+         * 
+         * @tparam Ts Datatypes serialized.
+         * @param values Values serialized.
+         * @return constexpr std::array<std::byte, size<Ts...>> Serialized bytes.
+         */
+        template <typename... Ts>
+        static constexpr std::array<std::byte, size<Ts...>> apply(const Ts &...values)
+        {
+            std::array<std::byte, size<Ts...>> out = {};
+            EmbeddedField<std::uint64_t>::write(out, 0, TypeHasher::fingerprint<TypeList<Ts...>>());
+            size_t offset = sizeof(std::uint64_t);
+            ((EmbeddedField<Ts>::write(out, offset, values), offset += EmbeddedField<Ts>::size), ...);
+            return out;
+        }
+    };
+
+    /**
+     * @brief Reader of the bytes written by EmbeddedSerialize. Every field is at a fixed offset, so get<I>() reads only that field,
+     * at compile time when the view and the bytes are constexpr.
+     * 
+     * @tparam Ts Datatypes serialized.
+     */
+    template <typename... Ts>
+    class EmbeddedView
+    {
+    public:
+        using bytes_t = std::array<std::byte, EmbeddedSerialize::size<Ts...>>;
+
+        /**
+         * @brief Create a view of the bytes, it fails to compile (or throws at run time) when the bytes were written for other datatypes.
+         * 
+         * @param data Serialized bytes, they must outlive the view.
+         */
+        constexpr explicit EmbeddedView(const bytes_t &data) : bytes(&data)
+        {
+            if (EmbeddedField<std::uint64_t>::read(data, 0) != TypeHasher::fingerprint<TypeList<Ts...>>())
+            {
+                throw std::runtime_error("Error while reading embedded data, it was serialized with different datatypes.");
+            }
+        }
+
+        /**
+         * @brief Decode the field I.
+         * 
+         * @tparam I Index of the field.
+         * @return constexpr auto Value of the field.
+         */
+        template <size_t I>
+        constexpr auto get() const
+        {
+            return EmbeddedField<type<I>>::read(*bytes, offset<I>());
+        }
+
+        /**
+         * @brief Characters of the FixedString field I, pointing into the serialized bytes.
+         * 
+         * @tparam I Index of the field.
+         * @return std::string_view Characters of the string.
+         */
+        template <size_t I>
+        std::string_view string() const
+        {
+            static_assert(IsFixedString<type<I>>::value, "Field is not a FixedString.");
+            const char *chars = reinterpret_cast<const char *>(bytes->data() + offset<I>() + sizeof(serial_size_t));
+            return std::string_view(chars, EmbeddedField<type<I>>::size - sizeof(serial_size_t));
+        }
+
+        template <size_t I>
+        using type = typename std::tuple_element<I, std::tuple<Ts...>>::type;
+
+        /**
+         * @brief Offset of the field I in the bytes.
+         * 
+         * @tparam I Index of the field.
+         * @return constexpr size_t Offset in bytes.
+         */
+        template <size_t I>
+        static constexpr size_t offset()
+        {
+            constexpr size_t sizes[] = {EmbeddedField<Ts>::size..., 0};
+            size_t result = sizeof(std::uint64_t);
+            for (size_t i = 0; i < I; ++i)
+            {
+                result += sizes[i];
+            }
+            return result;
+        }
+
+    private:
+        const bytes_t *bytes;
+    };
+};
@@ -0,0 +1,115 @@
+#pragma once
+
+#include "../Metaserializer.hpp"
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <vector>
+
+namespace Metaserializer
+{
+    /**
+     * @brief Sink which writes the serialized bytes to a file descriptor (POSIX) through a buffer, so objects of any size can be serialized
+     * to disk without building the whole message in memory. It can be used with Serialize<>::to, the fd is not closed by the sink.
+     * 
+     */
+    class FileSink
+    {
+    public:
+        /**
+         * @brief Create a sink for the file descriptor.
+         * 
+         * @param fd File descriptor opened for writing.
+         * @param capacity Bytes buffered before writing to the file, a single reserve bigger than it grows the buffer.
+         */
+        explicit FileSink(int fd, size_t capacity = 1 << 20) : fd(fd), buffer(capacity), used(0), written(0) {}
+
+        FileSink(const FileSink &) = delete;
+        FileSink &operator=(const FileSink &) = delete;
+
+        /**
+         * @brief The buffered bytes are written, errors can't be reported here so call flush before destroying the sink.
+         * 
+         */
+        ~FileSink()
+        {
+            try
+            {
+                flush();
+            }
+            catch (...)
+            {
+            }
+        }
+
+        /**
+         * @brief Get room for the next bytes.
+         * 
+         * @param size Number of bytes.
+         * @return unsigned char* Pointer where the bytes can be written.
+         */
+        unsigned char *reserve(size_t size)
+        {
+            if (buffer.size() - used < size)
+            {
+                flush();
+                if (buffer.size() < size)
+                {
+                    buffer.resize(size);
+                }
+            }
+            return buffer.data() + used;
+        }
+
+        /**
+         * @brief Keep the bytes written in the memory given by reserve.
+         * 
+         * @param size Number of bytes written.
+         */
+        void commit(size_t size)
+        {
+            used += size;
+        }
+
+        /**
+         * @brief Write the buffered bytes to the file.
+         * 
+         */
+        void flush()
+        {
+            size_t offset = 0;
+            while (offset < used)
+            {
+                const ssize_t bytes = ::write(fd, buffer.data() + offset, used - offset);
+                if (bytes < 0)
+                {
+                    if (errno == EINTR)
+                    {
+                        continue;
+                    }
+                    used = 0;
+                    throw std::runtime_error(std::string("Error while writing to file: ") + std::strerror(errno));
+                }
+                offset += static_cast<size_t>(bytes);
+            }
+            written += used;
+            used = 0;
+        }
+
+        /**
+         * @brief Number of bytes committed so far, including the ones still in the buffer.
+         * 
+         * @return size_t Number of bytes.
+         */
+        size_t bytes_written() const
+        {
+            return written + used;
+        }
+
+    private:
+        int fd;
+        std::vector<unsigned char> buffer;
+        size_t used;
+        size_t written;
+    };
+};
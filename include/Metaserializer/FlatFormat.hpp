@@ -0,0 +1,630 @@
+#pragma once
+
+#include "../Metaserializer.hpp"
+
+/**
+ * @brief Offset based in place format. Every table starts with the offsets of its fields (relative to the table), so any field
+ * (scalar, string, array or nested table) is read in O(1) directly from the bytes, without decoding nor allocating.
+ * 
+ * Root:   [u64 schema signature][table]
+ * Table:  [u32 field count][u32 offset of each field][field data...]
+ * String: [u32 length][bytes]['\0']
+ * Array:  [u32 count][elements aligned to their alignment]
+ * Vector: [u32 count][u32 offset of each element, relative to the vector][elements...]
+ */
+namespace Metaserializer
+{
+    typedef std::uint32_t flat_offset_t; //< Datatype of the counts and offsets inside the flat format.
+
+    template <typename T, typename Enable = void>
+    struct FlatField;
+
+    /**
+     * @brief Mix a value into a schema signature.
+     * 
+     * @param hash Current signature.
+     * @param value Value to mix.
+     * @return constexpr std::uint64_t New signature.
+     */
+    constexpr std::uint64_t flat_signature_mix(std::uint64_t hash, std::uint64_t value)
+    {
+        hash = (hash ^ value) * 1099511628211ull;
+        return hash ^ (hash >> 29);
+    }
+
+    /**
+     * @brief Read an offset/count stored in the flat format.
+     * 
+     * @param ptr Pointer to the value.
+     * @return flat_offset_t Value read.
+     */
+    inline flat_offset_t flat_read_offset(const unsigned char *ptr)
+    {
+        flat_offset_t value;
+        std::memcpy(&value, ptr, sizeof(flat_offset_t));
+        return value;
+    }
+
+    /**
+     * @brief View of an array of trivially copyable elements stored in a flat buffer.
+     * 
+     * @tparam T Element datatype.
+     */
+    template <typename T>
+    class FlatArray
+    {
+    public:
+        FlatArray() : elements(nullptr), count(0) {}
+        FlatArray(const unsigned char *elements, size_t count) : elements(elements), count(count) {}
+
+        size_t size() const
+        {
+            return count;
+        }
+
+        bool empty() const
+        {
+            return count == 0;
+        }
+
+        /**
+         * @brief Read an element, the buffer may be unaligned so the element is copied out.
+         * 
+         * @param index Position of the element.
+         * @return T Element.
+         */
+        T operator[](size_t index) const
+        {
+            T value;
+            std::memcpy(&value, elements + index * sizeof(T), sizeof(T));
+            return value;
+        }
+
+        /**
+         * @brief Get the raw bytes of the elements.
+         * 
+         * @return const unsigned char* Pointer to the first element.
+         */
+        const unsigned char *bytes() const
+        {
+            return elements;
+        }
+
+    private:
+        const unsigned char *elements;
+        size_t count;
+    };
+
+    /**
+     * @brief View of a vector of variable size elements (strings or tables) stored in a flat buffer.
+     * 
+     * @tparam T View datatype of the elements (std::string_view or FlatTable).
+     */
+    template <typename T>
+    class FlatVector
+    {
+    public:
+        FlatVector() : base(nullptr), bytes_size(0), count(0) {}
+        FlatVector(const unsigned char *base, size_t bytes_size, size_t count) : base(base), bytes_size(bytes_size), count(count) {}
+
+        size_t size() const
+        {
+            return count;
+        }
+
+        bool empty() const
+        {
+            return count == 0;
+        }
+
+        /**
+         * @brief Get an element.
+         * 
+         * @param index Position of the element.
+         * @return View of the element.
+         */
+        typename FlatField<T>::view_type operator[](size_t index) const
+        {
+            const flat_offset_t offset = flat_read_offset(base + sizeof(flat_offset_t) * (index + 1));
+            if (offset >= bytes_size)
+            {
+                throw std::runtime_error("Error while reading flat vector, element offset is out of the buffer.");
+            }
+            return FlatField<T>::read(base + offset, bytes_size - offset);
+        }
+
+    private:
+        const unsigned char *base;
+        size_t bytes_size;
+        size_t count;
+    };
+
+    /**
+     * @brief View of a table stored in a flat buffer, the datatypes are the views of its fields
+     * (scalars, std::string_view, FlatArray, FlatVector or nested FlatTable).
+     * 
+     * @tparam Ts View datatypes of the fields.
+     */
+    template <typename... Ts>
+    class FlatTable
+    {
+    public:
+        static constexpr size_t field_count = sizeof...(Ts); //< Number of fields of the table.
+
+        FlatTable() : base(nullptr), bytes_size(0) {}
+
+        /**
+         * @brief Construct a view of the table, only the header is checked.
+         * 
+         * @param base Pointer to the start of the table.
+         * @param bytes_size Bytes available from the start of the table.
+         */
+        FlatTable(const unsigned char *base, size_t bytes_size) : base(base), bytes_size(bytes_size)
+        {
+            const size_t header_size = sizeof(flat_offset_t) * (field_count + 1);
+            if (header_size > bytes_size || flat_read_offset(base) != field_count)
+            {
+                throw std::runtime_error("Error while reading flat table, header does not match the fields requested.");
+            }
+        }
+
+        /**
+         * @brief Get a view of the root table of a flat buffer, the schema signature must match.
+         * 
+         * @param data Pointer to the buffer.
+         * @param size Size of the buffer.
+         * @return FlatTable View of the root table.
+         */
+        static FlatTable from(const void *data, size_t size)
+        {
+            const unsigned char *bytes = static_cast<const unsigned char *>(data);
+            std::uint64_t signature_value;
+            if (size < sizeof(signature_value))
+            {
+                throw std::runtime_error("Error while reading flat buffer, data size is too small to be parsed.");
+            }
+            std::memcpy(&signature_value, bytes, sizeof(signature_value));
+            if (signature_value != signature())
+            {
+                throw std::runtime_error("Error while reading flat buffer, schema signature is different from the fields requested.");
+            }
+            return FlatTable(bytes + sizeof(signature_value), size - sizeof(signature_value));
+        }
+
+        /**
+         * @brief Get a view of the root table of a flat buffer.
+         * 
+         * @tparam TData Datatype of the object which contains the raw bytes.
+         * @param data Object which contains the raw bytes.
+         * @return FlatTable View of the root table.
+         */
+        template <typename TData>
+        static FlatTable from(const TData &data)
+        {
+            return from(data.data(), data.size());
+        }
+
+        /**
+         * @brief Read a field in O(1).
+         * 
+         * @tparam I Index of the field.
+         * @return View of the field.
+         */
+        template <size_t I>
+        typename FlatField<typename std::tuple_element<I, std::tuple<Ts...>>::type>::view_type get() const
+        {
+            using F = typename std::tuple_element<I, std::tuple<Ts...>>::type;
+            const flat_offset_t offset = flat_read_offset(base + sizeof(flat_offset_t) * (I + 1));
+            if (offset >= bytes_size)
+            {
+                throw std::runtime_error("Error while reading flat table, field offset is out of the buffer.");
+            }
+            return FlatField<F>::read(base + offset, bytes_size - offset);
+        }
+
+        /**
+         * @brief Signature of the schema of the table.
+         * 
+         * @return constexpr std::uint64_t Signature.
+         */
+        static constexpr std::uint64_t signature()
+        {
+            std::uint64_t hash = flat_signature_mix(0x5441424cull, field_count);
+            ((hash = flat_signature_mix(hash, FlatField<Ts>::signature())), ...);
+            return hash;
+        }
+
+    private:
+        const unsigned char *base;
+        size_t bytes_size;
+    };
+
+    /**
+     * @brief Builder which writes a flat buffer in one pass. Fields are appended in order, nested tables and vectors are written
+     * where they appear and the offset slots reserved in the table header are patched once each field is written.
+     * 
+     */
+    class FlatBuilder
+    {
+    public:
+        /**
+         * @brief Build a flat buffer with the fields given, read it with FlatTable of the corresponding views.
+         * Fields can be scalars, strings, std::vector, std::tuple (nested table) or views of a flat buffer.
+         * 
+         * @tparam Ts Datatypes of the fields.
+         * @param fields Fields of the root table.
+         * @return std::string Flat buffer.
+         */
+        template <typename... Ts>
+        static std::string build(const Ts &...fields)
+        {
+            FlatBuilder builder;
+            const std::uint64_t signature_value = FlatTable<typename FlatField<typename std::decay<Ts>::type>::view_type...>::signature();
+            builder.append(&signature_value, sizeof(signature_value));
+            builder.write_table(fields...);
+            return std::move(builder.buffer);
+        }
+
+        /**
+         * @brief Append padding until the end of the buffer is aligned.
+         * 
+         * @param alignment Alignment required.
+         * @param extra Bytes which will be written before the aligned position.
+         */
+        void align(size_t alignment, size_t extra = 0)
+        {
+            while ((buffer.size() + extra) % alignment != 0)
+            {
+                buffer.push_back('\0');
+            }
+        }
+
+        /**
+         * @brief Append raw bytes.
+         * 
+         * @param data Pointer to the bytes.
+         * @param size Number of bytes.
+         * @return size_t Position where the bytes were written.
+         */
+        size_t append(const void *data, size_t size)
+        {
+            const size_t position = buffer.size();
+            buffer.append(static_cast<const char *>(data), size);
+            return position;
+        }
+
+        /**
+         * @brief Append an offset/count.
+         * 
+         * @param value Value to append.
+         * @return size_t Position where the value was written.
+         */
+        size_t append_offset(size_t value)
+        {
+            if (value > std::numeric_limits<flat_offset_t>::max())
+            {
+                throw std::runtime_error("Error while building flat buffer, offset or count does not fit in 32 bits.");
+            }
+            const flat_offset_t offset = static_cast<flat_offset_t>(value);
+            return append(&offset, sizeof(offset));
+        }
+
+        /**
+         * @brief Write a value in a slot reserved before.
+         * 
+         * @param position Position of the slot.
+         * @param value Value to write.
+         */
+        void patch_offset(size_t position, size_t value)
+        {
+            if (value > std::numeric_limits<flat_offset_t>::max())
+            {
+                throw std::runtime_error("Error while building flat buffer, offset does not fit in 32 bits.");
+            }
+            const flat_offset_t offset = static_cast<flat_offset_t>(value);
+            std::memcpy(&buffer[position], &offset, sizeof(offset));
+        }
+
+        /**
+         * @brief Write a table with the fields given.
+         * 
+         * @tparam Ts Datatypes of the fields.
+         * @param fields Fields of the table.
+         * @return size_t Position of the table.
+         */
+        template <typename... Ts>
+        size_t write_table(const Ts &...fields)
+        {
+            align(sizeof(flat_offset_t));
+            const size_t start = append_offset(sizeof...(Ts));
+            buffer.append(sizeof(flat_offset_t) * sizeof...(Ts), '\0');
+            size_t slot = start + sizeof(flat_offset_t);
+            ((patch_offset(slot, FlatField<typename std::decay<Ts>::type>::write(*this, fields) - start), slot += sizeof(flat_offset_t)), ...);
+            return start;
+        }
+
+        /**
+         * @brief Write a vector of variable size elements.
+         * 
+         * @tparam It Iterator of the elements.
+         * @param first First element.
+         * @param last End of the elements.
+         * @return size_t Position of the vector.
+         */
+        template <typename It>
+        size_t write_vector(It first, It last)
+        {
+            using E = typename std::decay<decltype(*first)>::type;
+            align(sizeof(flat_offset_t));
+            const size_t count = std::distance(first, last);
+            const size_t start = append_offset(count);
+            buffer.append(sizeof(flat_offset_t) * count, '\0');
+            size_t slot = start + sizeof(flat_offset_t);
+            for (; first != last; ++first, slot += sizeof(flat_offset_t))
+            {
+                patch_offset(slot, FlatField<E>::write(*this, *first) - start);
+            }
+            return start;
+        }
+
+    private:
+        std::string buffer;
+    };
+
+    /**
+     * @brief Check if the datatype is a view of a flat buffer.
+     * 
+     * @tparam T Datatype to check.
+     */
+    template <typename T>
+    struct IsFlatView : std::false_type
+    {
+    };
+
+    template <typename T>
+    struct IsFlatView<FlatArray<T>> : std::true_type
+    {
+    };
+
+    template <typename T>
+    struct IsFlatView<FlatVector<T>> : std::true_type
+    {
+    };
+
+    template <typename... Ts>
+    struct IsFlatView<FlatTable<Ts...>> : std::true_type
+    {
+    };
+
+    /**
+     * @brief Scalars and other trivially copyable objects, stored aligned inside the table.
+     * 
+     * @tparam T Datatype of the field.
+     */
+    template <typename T>
+    struct FlatField<T, typename std::enable_if<IsSimpleObject<T>::value && !std::is_pointer<T>::value && !IsFlatView<T>::value>::type>
+    {
+        using view_type = T;
+
+        static constexpr std::uint64_t signature()
+        {
+            return TypeHasher::fingerprint<T>();
+        }
+
+        static size_t write(FlatBuilder &builder, const T &value)
+        {
+            builder.align(alignof(T));
+            return builder.append(&value, sizeof(T));
+        }
+
+        static T read(const unsigned char *ptr, size_t bytes_size)
+        {
+            if (sizeof(T) > bytes_size)
+            {
+                throw std::runtime_error("Error while reading flat field, buffer bytes remaining are too low to continue.");
+            }
+            T value;
+            std::memcpy(&value, ptr, sizeof(T));
+            return value;
+        }
+    };
+
+    /**
+     * @brief Strings, read as std::string_view pointing into the buffer.
+     * 
+     */
+    template <>
+    struct FlatField<std::string_view>
+    {
+        using view_type = std::string_view;
+
+        static constexpr std::uint64_t signature()
+        {
+            return 0x535452ull;
+        }
+
+        static size_t write(FlatBuilder &builder, std::string_view value)
+        {
+            builder.align(sizeof(flat_offset_t));
+            const size_t position = builder.append_offset(value.size());
+            builder.append(value.data(), value.size());
+            builder.append("", 1);
+            return position;
+        }
+
+        static std::string_view read(const unsigned char *ptr, size_t bytes_size)
+        {
+            if (sizeof(flat_offset_t) > bytes_size)
+            {
+                throw std::runtime_error("Error while reading flat string, buffer bytes remaining are too low to read the size.");
+            }
+            const flat_offset_t length = flat_read_offset(ptr);
+            if (length > bytes_size - sizeof(flat_offset_t))
+            {
+                throw std::runtime_error("Error while reading flat string, string size is bigger than the buffer.");
+            }
+            return std::string_view(reinterpret_cast<const char *>(ptr + sizeof(flat_offset_t)), length);
+        }
+    };
+
+    template <>
+    struct FlatField<std::string> : FlatField<std::string_view>
+    {
+    };
+
+    template <>
+    struct FlatField<const char *> : FlatField<std::string_view>
+    {
+    };
+
+    template <>
+    struct FlatField<char *> : FlatField<std::string_view>
+    {
+    };
+
+    /**
+     * @brief Arrays of trivially copyable elements, read as FlatArray.
+     * 
+     * @tparam T Element datatype.
+     */
+    template <typename T>
+    struct FlatField<FlatArray<T>>
+    {
+        static_assert(IsSimpleObject<T>::value, "FlatArray elements must be trivially copyable.");
+
+        using view_type = FlatArray<T>;
+
+        static constexpr std::uint64_t signature()
+        {
+            return flat_signature_mix(0x415252ull, FlatField<T>::signature());
+        }
+
+        static size_t write_elements(FlatBuilder &builder, const void *elements, size_t count)
+        {
+            builder.align(alignof(T) > sizeof(flat_offset_t) ? alignof(T) : sizeof(flat_offset_t), sizeof(flat_offset_t));
+            const size_t position = builder.append_offset(count);
+            builder.append(elements, count * sizeof(T));
+            return position;
+        }
+
+        static size_t write(FlatBuilder &builder, const FlatArray<T> &value)
+        {
+            return write_elements(builder, value.bytes(), value.size());
+        }
+
+        static FlatArray<T> read(const unsigned char *ptr, size_t bytes_size)
+        {
+            if (sizeof(flat_offset_t) > bytes_size)
+            {
+                throw std::runtime_error("Error while reading flat array, buffer bytes remaining are too low to read the size.");
+            }
+            const flat_offset_t count = flat_read_offset(ptr);
+            if (count > (bytes_size - sizeof(flat_offset_t)) / sizeof(T))
+            {
+                throw std::runtime_error("Error while reading flat array, array size is bigger than the buffer.");
+            }
+            return FlatArray<T>(ptr + sizeof(flat_offset_t), count);
+        }
+    };
+
+    /**
+     * @brief Vectors of variable size elements, read as FlatVector.
+     * 
+     * @tparam T View datatype of the elements.
+     */
+    template <typename T>
+    struct FlatField<FlatVector<T>>
+    {
+        using view_type = FlatVector<T>;
+
+        static constexpr std::uint64_t signature()
+        {
+            return flat_signature_mix(0x564543ull, FlatField<T>::signature());
+        }
+
+        static FlatVector<T> read(const unsigned char *ptr, size_t bytes_size)
+        {
+            if (sizeof(flat_offset_t) > bytes_size)
+            {
+                throw std::runtime_error("Error while reading flat vector, buffer bytes remaining are too low to read the size.");
+            }
+            const flat_offset_t count = flat_read_offset(ptr);
+            if (count >= bytes_size / sizeof(flat_offset_t))
+            {
+                throw std::runtime_error("Error while reading flat vector, vector size is bigger than the buffer.");
+            }
+            return FlatVector<T>(ptr, bytes_size, count);
+        }
+    };
+
+    /**
+     * @brief std::vector, written as an array when its elements are trivially copyable and as a vector otherwise.
+     * 
+     * @tparam T Element datatype.
+     */
+    template <typename T>
+    struct FlatField<std::vector<T>>
+    {
+        static const bool is_array = IsSimpleObject<T>::value && !std::is_pointer<T>::value;
+        using view_type = typename std::conditional<is_array, FlatArray<T>, FlatVector<typename FlatField<T>::view_type>>::type;
+
+        static constexpr std::uint64_t signature()
+        {
+            return FlatField<view_type>::signature();
+        }
+
+        static size_t write(FlatBuilder &builder, const std::vector<T> &value)
+        {
+            if constexpr (is_array)
+            {
+                return FlatField<FlatArray<T>>::write_elements(builder, value.data(), value.size());
+            }
+            else
+            {
+                return builder.write_vector(value.begin(), value.end());
+            }
+        }
+    };
+
+    /**
+     * @brief Nested tables, read as FlatTable.
+     * 
+     * @tparam Ts View datatypes of the fields.
+     */
+    template <typename... Ts>
+    struct FlatField<FlatTable<Ts...>>
+    {
+        using view_type = FlatTable<Ts...>;
+
+        static constexpr std::uint64_t signature()
+        {
+            return FlatTable<Ts...>::signature();
+        }
+
+        static FlatTable<Ts...> read(const unsigned char *ptr, size_t bytes_size)
+        {
+            return FlatTable<Ts...>(ptr, bytes_size);
+        }
+    };
+
+    /**
+     * @brief std::tuple, written as a nested table.
+     * 
+     * @tparam Ts Datatypes of the fields.
+     */
+    template <typename... Ts>
+    struct FlatField<std::tuple<Ts...>>
+    {
+        using view_type = FlatTable<typename FlatField<typename std::decay<Ts>::type>::view_type...>;
+
+        static constexpr std::uint64_t signature()
+        {
+            return view_type::signature();
+        }
+
+        static size_t write(FlatBuilder &builder, const std::tuple<Ts...> &value)
+        {
+            return std::apply([&builder](const auto &...fields) { return builder.write_table(fields...); }, value);
+        }
+    };
+};
@@ -0,0 +1,324 @@
+#pragma once
+
+#include "../Metaserializer.hpp"
+#include <sys/mman.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <sys/syscall.h>
+#endif
+
+namespace Metaserializer
+{
+    /**
+     * @brief How the memory of a LargeBuffer is allocated: huge pages reduce the TLB misses on buffers of hundreds of MB and binding
+     * the memory to the NUMA node of the thread avoids the traffic between sockets. Every option falls back to normal pages or
+     * the default NUMA policy when the system does not support it.
+     * 
+     */
+    struct BufferPolicy
+    {
+        enum class HugePages
+        {
+            none,        //< Normal pages.
+            transparent, //< 2 MB aligned memory with madvise(MADV_HUGEPAGE).
+            explicit_    //< Pages reserved by the administrator (MAP_HUGETLB), transparent when there are none free.
+        };
+
+        static const int no_node = -1;    //< Default NUMA policy of the process.
+        static const int local_node = -2; //< Node of the CPU running the thread which allocates.
+
+        HugePages huge_pages = HugePages::transparent;
+        int numa_node = no_node;
+        bool strict = false; //< Allocate only in the node (MPOL_BIND) instead of preferring it (MPOL_PREFERRED).
+
+        static const size_t huge_page_size = 2 << 20;
+        static const size_t min_huge_size = 2 << 20; //< Smaller buffers always use normal pages.
+    };
+
+    /**
+     * @brief Growable buffer allocated with a BufferPolicy. It is a sink for Serialize<>::to and it can be given to Unserialize<>::apply
+     * like a std::string (data and size). It can be moved but not copied.
+     * 
+     */
+    class LargeBuffer
+    {
+    public:
+        /**
+         * @brief Create the buffer, the memory is allocated but not touched so the NUMA binding applies to every page.
+         * 
+         * @param capacity Bytes allocated at first.
+         * @param policy Allocation policy used now and when the buffer grows.
+         */
+        explicit LargeBuffer(size_t capacity = 0, BufferPolicy policy = BufferPolicy())
+            : policy(policy), bytes(nullptr), length(0), allocated(0), huge(BufferPolicy::HugePages::none), bound(false)
+        {
+            if (capacity > 0)
+            {
+                reallocate(capacity);
+            }
+        }
+
+        LargeBuffer(LargeBuffer &&other) noexcept
+            : policy(other.policy), bytes(other.bytes), length(other.length), allocated(other.allocated), huge(other.huge), bound(other.bound)
+        {
+            other.bytes = nullptr;
+            other.length = 0;
+            other.allocated = 0;
+        }
+
+        LargeBuffer &operator=(LargeBuffer &&other) noexcept
+        {
+            if (this != &other)
+            {
+                release();
+                policy = other.policy;
+                bytes = other.bytes;
+                length = other.length;
+                allocated = other.allocated;
+                huge = other.huge;
+                bound = other.bound;
+                other.bytes = nullptr;
+                other.length = 0;
+                other.allocated = 0;
+            }
+            return *this;
+        }
+
+        LargeBuffer(const LargeBuffer &) = delete;
+        LargeBuffer &operator=(const LargeBuffer &) = delete;
+
+        ~LargeBuffer()
+        {
+            release();
+        }
+
+        /**
+         * @brief Get room for the next bytes, growing the buffer when needed.
+         * 
+         * @param size Number of bytes.
+         * @return unsigned char* Pointer where the bytes can be written, valid until the next reserve.
+         */
+        unsigned char *reserve(size_t size)
+        {
+            if (allocated - length < size)
+            {
+                reallocate(std::max(allocated * 2, length + size));
+            }
+            return bytes + length;
+        }
+
+        /**
+         * @brief Keep the bytes written in the memory given by reserve.
+         * 
+         * @param size Number of bytes written.
+         */
+        void commit(size_t size)
+        {
+            length += size;
+        }
+
+        /**
+         * @brief Change the number of bytes in the buffer, the new bytes are not initialized (e.g. to read a file into data()).
+         * 
+         * @param size Number of bytes.
+         */
+        void resize(size_t size)
+        {
+            if (size > allocated)
+            {
+                reallocate(size);
+            }
+            length = size;
+        }
+
+        void clear()
+        {
+            length = 0;
+        }
+
+        unsigned char *data()
+        {
+            return bytes;
+        }
+
+        const unsigned char *data() const
+        {
+            return bytes;
+        }
+
+        size_t size() const
+        {
+            return length;
+        }
+
+        size_t capacity() const
+        {
+            return allocated;
+        }
+
+        std::string_view view() const
+        {
+            return std::string_view(reinterpret_cast<const char *>(bytes), length);
+        }
+
+        /**
+         * @brief Huge pages actually used by the current allocation.
+         * 
+         * @return BufferPolicy::HugePages Kind of pages.
+         */
+        BufferPolicy::HugePages huge_pages() const
+        {
+            return huge;
+        }
+
+        /**
+         * @brief Check if the current allocation was bound to the NUMA node of the policy.
+         * 
+         */
+        bool numa_bound() const
+        {
+            return bound;
+        }
+
+    private:
+        BufferPolicy policy;
+        unsigned char *bytes;
+        size_t length;
+        size_t allocated;
+        BufferPolicy::HugePages huge;
+        bool bound;
+
+        static size_t round_up(size_t size, size_t unit)
+        {
+            return (size + unit - 1) / unit * unit;
+        }
+
+        static size_t page_size()
+        {
+            static const size_t size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+            return size;
+        }
+
+        void release()
+        {
+            if (bytes != nullptr)
+            {
+                ::munmap(bytes, allocated);
+                bytes = nullptr;
+                length = 0;
+                allocated = 0;
+            }
+        }
+
+        /**
+         * @brief Move the bytes to a new allocation of at least the size given.
+         * 
+         */
+        void reallocate(size_t size)
+        {
+            BufferPolicy::HugePages new_huge = BufferPolicy::HugePages::none;
+            size_t new_size = 0;
+            unsigned char *address = allocate(size, new_huge, new_size);
+            const bool new_bound = bind(address, new_size);
+            if (length > 0)
+            {
+                std::memcpy(address, bytes, length);
+            }
+            const size_t used = length;
+            release();
+            bytes = address;
+            length = used;
+            allocated = new_size;
+            huge = new_huge;
+            bound = new_bound;
+        }
+
+        unsigned char *allocate(size_t size, BufferPolicy::HugePages &used_pages, size_t &allocated_size) const
+        {
+            const bool big = size >= BufferPolicy::min_huge_size;
+#if defined(MAP_HUGETLB)
+            if (big && policy.huge_pages == BufferPolicy::HugePages::explicit_)
+            {
+                allocated_size = round_up(size, BufferPolicy::huge_page_size);
+                void *address = ::mmap(nullptr, allocated_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+                if (address != MAP_FAILED)
+                {
+                    used_pages = BufferPolicy::HugePages::explicit_;
+                    return static_cast<unsigned char *>(address);
+                }
+            }
+#endif
+            if (big && policy.huge_pages != BufferPolicy::HugePages::none)
+            {
+                // Map one huge page more and trim it, so the buffer starts at a huge page boundary.
+                allocated_size = round_up(size, BufferPolicy::huge_page_size);
+                const size_t mapped = allocated_size + BufferPolicy::huge_page_size;
+                void *address = ::mmap(nullptr, mapped, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+                if (address == MAP_FAILED)
+                {
+                    throw std::bad_alloc();
+                }
+                unsigned char *start = static_cast<unsigned char *>(address);
+                unsigned char *aligned = reinterpret_cast<unsigned char *>(round_up(reinterpret_cast<size_t>(start), BufferPolicy::huge_page_size));
+                if (aligned > start)
+                {
+                    ::munmap(start, aligned - start);
+                }
+                if (aligned + allocated_size < start + mapped)
+                {
+                    ::munmap(aligned + allocated_size, start + mapped - aligned - allocated_size);
+                }
+#if defined(MADV_HUGEPAGE)
+                used_pages = ::madvise(aligned, allocated_size, MADV_HUGEPAGE) == 0 ? BufferPolicy::HugePages::transparent : BufferPolicy::HugePages::none;
+#endif
+                return aligned;
+            }
+
+            allocated_size = round_up(size, page_size());
+            void *address = ::mmap(nullptr, allocated_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (address == MAP_FAILED)
+            {
+                throw std::bad_alloc();
+            }
+            return static_cast<unsigned char *>(address);
+        }
+
+        /**
+         * @brief Apply the NUMA policy to the memory (mbind) before it is touched, the system call is used directly so libnuma is not needed.
+         * 
+         */
+        bool bind(unsigned char *address, size_t size) const
+        {
+#if defined(__linux__) && defined(SYS_mbind) && defined(SYS_getcpu)
+            int node = policy.numa_node;
+            if (node == BufferPolicy::no_node)
+            {
+                return false;
+            }
+            if (node == BufferPolicy::local_node)
+            {
+                unsigned cpu = 0, current = 0;
+                if (::syscall(SYS_getcpu, &cpu, &current, nullptr) != 0)
+                {
+                    return false;
+                }
+                node = static_cast<int>(current);
+            }
+            static const int mpol_preferred = 1;
+            static const int mpol_bind = 2;
+            unsigned long mask[4] = {};
+            const size_t bits = sizeof(unsigned long) * 8;
+            if (node < 0 || static_cast<size_t>(node) >= bits * 4)
+            {
+                return false;
+            }
+            mask[node / bits] = 1ul << (node % bits);
+            return ::syscall(SYS_mbind, address, size, policy.strict ? mpol_bind : mpol_preferred, mask, bits * 4 + 1, 0) == 0;
+#else
+            (void)address;
+            (void)size;
+            return false;
+#endif
+        }
+    };
+};
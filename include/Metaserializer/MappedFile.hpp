@@ -0,0 +1,128 @@
+#pragma once
+
+#include "../Metaserializer.hpp"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace Metaserializer
+{
+    /**
+     * @brief Read only memory mapping of a whole file (POSIX). The mapping is released when the object is destroyed, it can be moved but not copied.
+     * 
+     */
+    class MappedFile
+    {
+    public:
+        MappedFile() : bytes(nullptr), length(0) {}
+
+        /**
+         * @brief Map a file in memory.
+         * 
+         * @param path Path of the file.
+         * @return MappedFile Mapping of the whole file.
+         */
+        static MappedFile open(const std::string &path)
+        {
+            const int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+            if (fd < 0)
+            {
+                throw std::runtime_error("Error while mapping file, can't open " + path + ": " + std::strerror(errno));
+            }
+            struct stat info;
+            if (::fstat(fd, &info) != 0)
+            {
+                const int error = errno;
+                ::close(fd);
+                throw std::runtime_error("Error while mapping file, can't stat " + path + ": " + std::strerror(error));
+            }
+
+            MappedFile file;
+            file.length = static_cast<size_t>(info.st_size);
+            if (file.length > 0)
+            {
+                void *address = ::mmap(nullptr, file.length, PROT_READ, MAP_SHARED, fd, 0);
+                if (address == MAP_FAILED)
+                {
+                    const int error = errno;
+                    ::close(fd);
+                    throw std::runtime_error("Error while mapping file, can't map " + path + ": " + std::strerror(error));
+                }
+                file.bytes = static_cast<const unsigned char *>(address);
+            }
+            ::close(fd);
+            return file;
+        }
+
+        MappedFile(MappedFile &&other) noexcept : bytes(other.bytes), length(other.length)
+        {
+            other.bytes = nullptr;
+            other.length = 0;
+        }
+
+        MappedFile &operator=(MappedFile &&other) noexcept
+        {
+            if (this != &other)
+            {
+                unmap();
+                bytes = other.bytes;
+                length = other.length;
+                other.bytes = nullptr;
+                other.length = 0;
+            }
+            return *this;
+        }
+
+        MappedFile(const MappedFile &) = delete;
+        MappedFile &operator=(const MappedFile &) = delete;
+
+        ~MappedFile()
+        {
+            unmap();
+        }
+
+        const unsigned char *data() const
+        {
+            return bytes;
+        }
+
+        size_t size() const
+        {
+            return length;
+        }
+
+        bool empty() const
+        {
+            return length == 0;
+        }
+
+        /**
+         * @brief Give the kernel a hint about how the mapping will be used (madvise).
+         * 
+         * @param advice MADV_SEQUENTIAL, MADV_RANDOM, MADV_WILLNEED...
+         */
+        void advise(int advice) const
+        {
+            if (length > 0)
+            {
+                ::madvise(const_cast<unsigned char *>(bytes), length, advice);
+            }
+        }
+
+    private:
+        const unsigned char *bytes;
+        size_t length;
+
+        void unmap()
+        {
+            if (bytes != nullptr)
+            {
+                ::munmap(const_cast<unsigned char *>(bytes), length);
+                bytes = nullptr;
+                length = 0;
+            }
+        }
+    };
+};
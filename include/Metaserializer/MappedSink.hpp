@@ -0,0 +1,225 @@
+#pragma once
+
+#include "../Metaserializer.hpp"
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace Metaserializer
+{
+    /**
+     * @brief Sink which writes the serialized bytes directly in the pages of a memory mapped file (POSIX). The file grows while it is written
+     * (posix_fallocate and mremap on Linux) and the pages already written are released from the process (MADV_DONTNEED) once they are behind the
+     * written bytes, so outputs bigger than the memory can be written with a bounded resident size and no copy in user space.
+     * It can be used with Serialize<>::to, the pointer returned by reserve is valid until the next reserve (the mapping can move when it grows).
+     * 
+     */
+    class MappedSink
+    {
+    public:
+        /**
+         * @brief Create (or truncate) the file and map its first bytes.
+         * 
+         * @param path Path of the file.
+         * @param initial_capacity Bytes mapped at first, the mapping doubles each time it gets full.
+         * @param release_interval Written bytes kept in the process before they are released to the page cache.
+         */
+        explicit MappedSink(const std::string &path, size_t initial_capacity = 64 << 20, size_t release_interval = 32 << 20)
+            : fd(-1), bytes(nullptr), capacity(round_to_page(initial_capacity == 0 ? 1 : initial_capacity)), committed(0), released(0), release_interval(release_interval)
+        {
+            fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0)
+            {
+                throw std::runtime_error("Error while creating mapped file, can't open " + path + ": " + std::strerror(errno));
+            }
+            const int allocate_error = allocate(fd, 0, capacity);
+            if (allocate_error != 0)
+            {
+                ::close(fd);
+                throw std::runtime_error("Error while creating mapped file, can't resize " + path + ": " + std::strerror(allocate_error));
+            }
+            void *address = ::mmap(nullptr, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            if (address == MAP_FAILED)
+            {
+                const int error = errno;
+                ::close(fd);
+                throw std::runtime_error("Error while creating mapped file, can't map " + path + ": " + std::strerror(error));
+            }
+            bytes = static_cast<unsigned char *>(address);
+            ::madvise(bytes, capacity, MADV_SEQUENTIAL);
+        }
+
+        MappedSink(const MappedSink &) = delete;
+        MappedSink &operator=(const MappedSink &) = delete;
+
+        /**
+         * @brief The file is closed with its final size, errors can't be reported here so call close before destroying the sink.
+         * 
+         */
+        ~MappedSink()
+        {
+            try
+            {
+                close();
+            }
+            catch (...)
+            {
+            }
+        }
+
+        /**
+         * @brief Get room for the next bytes, growing the file when needed.
+         * 
+         * @param size Number of bytes.
+         * @return unsigned char* Pointer to the file pages where the bytes can be written.
+         */
+        unsigned char *reserve(size_t size)
+        {
+            if (capacity - committed < size)
+            {
+                grow(committed + size);
+            }
+            return bytes + committed;
+        }
+
+        /**
+         * @brief Keep the bytes written in the memory given by reserve.
+         * 
+         * @param size Number of bytes written.
+         */
+        void commit(size_t size)
+        {
+            committed += size;
+            if (committed - released >= release_interval + page_size())
+            {
+                release(committed);
+            }
+        }
+
+        /**
+         * @brief Write the dirty pages to the file and wait for them (msync).
+         * 
+         */
+        void flush()
+        {
+            if (bytes != nullptr && ::msync(bytes, round_to_page(committed), MS_SYNC) != 0)
+            {
+                throw std::runtime_error(std::string("Error while flushing mapped file: ") + std::strerror(errno));
+            }
+        }
+
+        /**
+         * @brief Unmap the file and truncate it to the bytes written.
+         * 
+         */
+        void close()
+        {
+            if (fd < 0)
+            {
+                return;
+            }
+            if (bytes != nullptr)
+            {
+                ::munmap(bytes, capacity);
+                bytes = nullptr;
+            }
+            const int result = ::ftruncate(fd, static_cast<off_t>(committed));
+            const int error = errno;
+            ::close(fd);
+            fd = -1;
+            if (result != 0)
+            {
+                throw std::runtime_error(std::string("Error while closing mapped file, can't truncate: ") + std::strerror(error));
+            }
+        }
+
+        /**
+         * @brief Number of bytes committed so far.
+         * 
+         * @return size_t Number of bytes.
+         */
+        size_t bytes_written() const
+        {
+            return committed;
+        }
+
+    private:
+        int fd;
+        unsigned char *bytes;
+        size_t capacity;
+        size_t committed;
+        size_t released; //< Bytes at the beginning of the mapping already released from the process.
+        size_t release_interval;
+
+        static size_t page_size()
+        {
+            static const size_t size = static_cast<size_t>(::sysconf(_SC_PAGESIZE));
+            return size;
+        }
+
+        static size_t round_to_page(size_t size)
+        {
+            return (size + page_size() - 1) / page_size() * page_size();
+        }
+
+        /**
+         * @brief Grow the file to the new size with its blocks allocated, so a full disk is an error here instead of a SIGBUS when
+         * the mapping is written. File systems without posix_fallocate fall back to ftruncate (a sparse file).
+         * 
+         * @return int 0 or the error number.
+         */
+        static int allocate(int fd, size_t old_size, size_t new_size)
+        {
+            const int error = ::posix_fallocate(fd, static_cast<off_t>(old_size), static_cast<off_t>(new_size - old_size));
+            if (error == EINVAL || error == EOPNOTSUPP)
+            {
+                return ::ftruncate(fd, static_cast<off_t>(new_size)) == 0 ? 0 : errno;
+            }
+            return error;
+        }
+
+        /**
+         * @brief Release the whole pages before the offset, their bytes stay in the page cache and are written to the file by the kernel.
+         * 
+         */
+        void release(size_t offset)
+        {
+            const size_t end = offset / page_size() * page_size();
+            if (end > released)
+            {
+                ::madvise(bytes + released, end - released, MADV_DONTNEED);
+                released = end;
+            }
+        }
+
+        void grow(size_t needed)
+        {
+            size_t new_capacity = capacity;
+            while (new_capacity < needed)
+            {
+                new_capacity *= 2;
+            }
+            const int allocate_error = allocate(fd, capacity, new_capacity);
+            if (allocate_error != 0)
+            {
+                throw std::runtime_error(std::string("Error while growing mapped file, can't resize: ") + std::strerror(allocate_error));
+            }
+#if defined(MREMAP_MAYMOVE)
+            void *address = ::mremap(bytes, capacity, new_capacity, MREMAP_MAYMOVE);
+#else
+            release(committed);
+            ::munmap(bytes, capacity);
+            bytes = nullptr;
+            void *address = ::mmap(nullptr, new_capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+#endif
+            if (address == MAP_FAILED)
+            {
+                throw std::runtime_error(std::string("Error while growing mapped file, can't map: ") + std::strerror(errno));
+            }
+            bytes = static_cast<unsigned char *>(address);
+            capacity = new_capacity;
+            ::madvise(bytes, capacity, MADV_SEQUENTIAL);
+        }
+    };
+};
@@ -0,0 +1,592 @@
+#pragma once
+
+#include "../Metaserializer.hpp"
+#include "MappedFile.hpp"
+
+/**
+ * @brief Hash table format built with a minimal perfect hash (hash and displace) at write time and queried in place,
+ * typically from a memory mapped file: loading is instant and a lookup reads the bucket seed, the slot and the record.
+ * 
+ * [header][u32 seed per bucket][u64 slot per key: 16 bits tag | 48 bits record offset][records: u32 key size, key, u32 value size, value]
+ */
+namespace Metaserializer
+{
+    /**
+     * @brief Bytes hashed and compared for a key, trivially copyable keys use its canonical bytes (see CanonicalObject) so padding
+     * bytes are ignored, -0.0 is the key 0.0 and every NaN is the same key.
+     * 
+     * @tparam K Key datatype.
+     */
+    template <typename K>
+    struct PerfectHashKey
+    {
+        static_assert(IsSimpleObject<K>::value, "Perfect hash keys must be trivially copyable or strings.");
+
+        using buffer_type = std::array<unsigned char, sizeof(K)>;
+
+        static std::string_view bytes(const K &key, buffer_type &buffer)
+        {
+            CanonicalObject<K>::copy(key, buffer.data());
+            return std::string_view(reinterpret_cast<const char *>(buffer.data()), sizeof(K));
+        }
+    };
+
+    template <>
+    struct PerfectHashKey<std::string_view>
+    {
+        struct buffer_type
+        {
+        };
+
+        static std::string_view bytes(std::string_view key, buffer_type &)
+        {
+            return key;
+        }
+    };
+
+    template <>
+    struct PerfectHashKey<std::string> : PerfectHashKey<std::string_view>
+    {
+    };
+
+    /**
+     * @brief Header of the perfect hash table format.
+     * 
+     */
+    struct PerfectHashHeader
+    {
+        static const std::uint32_t magic_value = 0x4850534d; //< "MSPH"
+        static const std::uint32_t version_value = 1;
+
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint64_t signature;    //< Fingerprint of the key and value datatypes.
+        std::uint64_t count;        //< Number of keys (and slots).
+        std::uint64_t bucket_count; //< Number of buckets.
+        std::uint64_t seed;         //< Seed of the key hash.
+        std::uint64_t records_size; //< Bytes of the records section.
+
+        /**
+         * @brief Signature of the key and value datatypes.
+         * 
+         * @tparam K Key datatype.
+         * @tparam V Value datatype.
+         * @return constexpr std::uint64_t Signature.
+         */
+        template <typename K, typename V>
+        static constexpr std::uint64_t signature_of()
+        {
+            using key_type = typename HashAs<typename std::decay<K>::type>::type;
+            using value_type = typename HashAs<typename std::decay<V>::type>::type;
+            return (TypeHasher::fingerprint<key_type>() * 1099511628211ull) ^ TypeHasher::fingerprint<value_type>();
+        }
+
+        /**
+         * @brief Bucket of a key hash.
+         * 
+         * @param hash Hash of the key.
+         * @return std::uint64_t Bucket index.
+         */
+        std::uint64_t bucket_of(std::uint64_t hash) const
+        {
+            return (hash >> 32) % bucket_count;
+        }
+
+        /**
+         * @brief Slot of a key hash given the seed of its bucket. Buckets with a single key store the slot directly (highest bit set).
+         * 
+         * @param hash Hash of the key.
+         * @param bucket_seed Seed of the bucket.
+         * @return std::uint64_t Slot index.
+         */
+        std::uint64_t slot_of(std::uint64_t hash, std::uint32_t bucket_seed) const
+        {
+            if (bucket_seed & direct_flag)
+            {
+                return bucket_seed & ~direct_flag;
+            }
+            std::uint64_t mixed = hash ^ (bucket_seed * 0x9e3779b97f4a7c15ull);
+            mixed = (mixed ^ (mixed >> 30)) * 0xbf58476d1ce4e5b9ull;
+            mixed = (mixed ^ (mixed >> 27)) * 0x94d049bb133111ebull;
+            mixed ^= mixed >> 31;
+            return mixed % count;
+        }
+
+        /**
+         * @brief Tag stored in the slot to reject most misses without reading the record.
+         * 
+         * @param hash Hash of the key.
+         * @return std::uint64_t Tag.
+         */
+        static std::uint64_t tag_of(std::uint64_t hash)
+        {
+            return hash & 0xffff;
+        }
+
+        static const std::uint32_t direct_flag = 0x80000000u; //< Bucket seed flag, the rest of the bits are the slot.
+        static const std::uint64_t offset_mask = (1ull << 48) - 1; //< Record offset bits of a slot.
+    };
+
+    /**
+     * @brief Writer of the perfect hash table format.
+     * 
+     */
+    struct PerfectHashTableWriter
+    {
+        static const size_t max_attempts = 64;      //< Global seeds tried before giving up.
+        static const std::uint32_t max_displacement = 1u << 20; //< Seeds tried for each bucket.
+
+        /**
+         * @brief Build the table.
+         * 
+         * @tparam TEntries Range of pairs (std::map, std::unordered_map, std::vector<std::pair<K, V>>...), keys must be unique.
+         * @param entries Keys and values.
+         * @return std::string Serialized table.
+         */
+        template <typename TEntries>
+        static std::string build(const TEntries &entries)
+        {
+            using entry_type = typename std::decay<decltype(*std::begin(entries))>::type;
+            using K = typename std::decay<typename entry_type::first_type>::type;
+            using V = typename std::decay<typename entry_type::second_type>::type;
+
+            std::vector<const entry_type *> items;
+            for (const auto &entry : entries)
+            {
+                items.push_back(&entry);
+            }
+            const size_t count = items.size();
+            if (count >= PerfectHashHeader::direct_flag)
+            {
+                throw std::runtime_error("Error while building perfect hash table, too many keys.");
+            }
+
+            PerfectHashHeader header = {};
+            header.magic = PerfectHashHeader::magic_value;
+            header.version = PerfectHashHeader::version_value;
+            header.signature = PerfectHashHeader::signature_of<K, V>();
+            header.count = count;
+            header.bucket_count = count / 3 + 1;
+
+            std::vector<std::uint64_t> hashes(count);
+            std::vector<std::uint32_t> seeds;
+            std::vector<std::uint64_t> slot_of_item;
+            typename PerfectHashKey<K>::buffer_type buffer;
+            bool built = false;
+            for (size_t attempt = 0; attempt < max_attempts && !built; ++attempt)
+            {
+                header.seed = attempt;
+                for (size_t i = 0; i < count; ++i)
+                {
+                    const std::string_view key = PerfectHashKey<K>::bytes(items[i]->first, buffer);
+                    hashes[i] = XXHash64::hash(key.data(), key.size(), header.seed);
+                }
+                if (attempt == 0)
+                {
+                    check_duplicates<K>(items, hashes);
+                }
+                built = place(header, hashes, seeds, slot_of_item);
+            }
+            if (!built)
+            {
+                throw std::runtime_error("Error while building perfect hash table, can't find a perfect hash (duplicated keys?).");
+            }
+
+            std::vector<size_t> item_in_slot(count);
+            for (size_t i = 0; i < count; ++i)
+            {
+                item_in_slot[slot_of_item[i]] = i;
+            }
+
+            std::string records;
+            std::vector<std::uint64_t> slots(count);
+            for (size_t slot = 0; slot < count; ++slot)
+            {
+                const size_t i = item_in_slot[slot];
+                if (records.size() > PerfectHashHeader::offset_mask)
+                {
+                    throw std::runtime_error("Error while building perfect hash table, records are too big.");
+                }
+                slots[slot] = (PerfectHashHeader::tag_of(hashes[i]) << 48) | records.size();
+                const std::string_view key = PerfectHashKey<K>::bytes(items[i]->first, buffer);
+                append_u32(records, key.size());
+                records.append(key.data(), key.size());
+                // The serializers take non const references but they do not modify the value.
+                V &value = const_cast<V &>(items[i]->second);
+                const size_t value_size = TypeSizer::apply(value);
+                append_u32(records, value_size);
+                StringSink sink(records);
+                Serialize<>::write_to(sink, value);
+            }
+            header.records_size = records.size();
+
+            std::string result;
+            result.reserve(sizeof(header) + seeds.size() * sizeof(std::uint32_t) + slots.size() * sizeof(std::uint64_t) + records.size());
+            result.append(reinterpret_cast<const char *>(&header), sizeof(header));
+            result.append(reinterpret_cast<const char *>(seeds.data()), seeds.size() * sizeof(std::uint32_t));
+            result.append((8 - result.size() % 8) % 8, '\0');
+            result.append(reinterpret_cast<const char *>(slots.data()), slots.size() * sizeof(std::uint64_t));
+            result.append(records);
+            return result;
+        }
+
+        /**
+         * @brief Build the table and write it to a file, open it with PerfectHashTable::open. The table is written to a temporary
+         * file which is synced and renamed to the path, so readers which have the previous table mapped keep reading it.
+         * 
+         * @tparam TEntries Range of pairs, keys must be unique.
+         * @param path Path of the file.
+         * @param entries Keys and values.
+         */
+        template <typename TEntries>
+        static void write(const std::string &path, const TEntries &entries)
+        {
+            const std::string table = build(entries);
+            const std::string temporary = path + ".tmp";
+            const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0)
+            {
+                throw std::runtime_error("Error while writing perfect hash table, can't open " + temporary + ": " + std::strerror(errno));
+            }
+
+            int error = 0;
+            for (size_t written = 0; written < table.size() && error == 0;)
+            {
+                const ssize_t result = ::write(fd, table.data() + written, table.size() - written);
+                if (result >= 0)
+                {
+                    written += static_cast<size_t>(result);
+                }
+                else if (errno != EINTR)
+                {
+                    error = errno;
+                }
+            }
+            if (error == 0 && ::fsync(fd) != 0)
+            {
+                error = errno;
+            }
+            if (::close(fd) != 0 && error == 0)
+            {
+                error = errno;
+            }
+            if (error == 0 && ::rename(temporary.c_str(), path.c_str()) != 0)
+            {
+                error = errno;
+            }
+            if (error != 0)
+            {
+                ::unlink(temporary.c_str());
+                throw std::runtime_error("Error while writing perfect hash table to " + path + ": " + std::strerror(error));
+            }
+        }
+
+    private:
+        /**
+         * @brief Throw if two entries have the same key, they would never get different slots.
+         * 
+         */
+        template <typename K, typename TItems>
+        static void check_duplicates(const TItems &items, const std::vector<std::uint64_t> &hashes)
+        {
+            std::vector<size_t> order(items.size());
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                order[i] = i;
+            }
+            std::sort(order.begin(), order.end(), [&hashes](size_t left, size_t right) { return hashes[left] < hashes[right]; });
+            for (size_t i = 1; i < order.size(); ++i)
+            {
+                typename PerfectHashKey<K>::buffer_type left, right;
+                if (hashes[order[i - 1]] == hashes[order[i]] &&
+                    PerfectHashKey<K>::bytes(items[order[i - 1]]->first, left) == PerfectHashKey<K>::bytes(items[order[i]]->first, right))
+                {
+                    throw std::runtime_error("Error while building perfect hash table, duplicated key.");
+                }
+            }
+        }
+
+        static void append_u32(std::string &result, size_t value)
+        {
+            if (value > std::numeric_limits<std::uint32_t>::max())
+            {
+                throw std::runtime_error("Error while building perfect hash table, key or value is too big.");
+            }
+            const std::uint32_t size = static_cast<std::uint32_t>(value);
+            result.append(reinterpret_cast<const char *>(&size), sizeof(size));
+        }
+
+        /**
+         * @brief Hash and displace: buckets are placed from the biggest to the smallest, each one searching a seed which sends all its keys to free slots.
+         * 
+         * @return true Every key got a slot.
+         * @return false Some bucket could not be placed, try another global seed.
+         */
+        static bool place(const PerfectHashHeader &header, const std::vector<std::uint64_t> &hashes, std::vector<std::uint32_t> &seeds, std::vector<std::uint64_t> &slot_of_item)
+        {
+            const size_t count = hashes.size();
+            const size_t bucket_count = header.bucket_count;
+
+            std::vector<size_t> bucket_start(bucket_count + 1, 0);
+            for (size_t i = 0; i < count; ++i)
+            {
+                ++bucket_start[header.bucket_of(hashes[i]) + 1];
+            }
+            for (size_t b = 0; b < bucket_count; ++b)
+            {
+                bucket_start[b + 1] += bucket_start[b];
+            }
+            std::vector<size_t> bucket_items(count);
+            std::vector<size_t> fill(bucket_start.begin(), bucket_start.end() - 1);
+            for (size_t i = 0; i < count; ++i)
+            {
+                bucket_items[fill[header.bucket_of(hashes[i])]++] = i;
+            }
+
+            std::vector<size_t> order(bucket_count);
+            for (size_t b = 0; b < bucket_count; ++b)
+            {
+                order[b] = b;
+            }
+            std::stable_sort(order.begin(), order.end(), [&bucket_start](size_t left, size_t right) {
+                return bucket_start[left + 1] - bucket_start[left] > bucket_start[right + 1] - bucket_start[right];
+            });
+
+            seeds.assign(bucket_count, 0);
+            slot_of_item.assign(count, 0);
+            std::vector<bool> taken(count, false);
+            std::vector<std::uint64_t> candidate;
+            size_t next_free = 0;
+            for (size_t b : order)
+            {
+                const size_t first = bucket_start[b];
+                const size_t size = bucket_start[b + 1] - first;
+                if (size == 0)
+                {
+                    break;
+                }
+                if (size == 1)
+                {
+                    while (taken[next_free])
+                    {
+                        ++next_free;
+                    }
+                    taken[next_free] = true;
+                    slot_of_item[bucket_items[first]] = next_free;
+                    seeds[b] = PerfectHashHeader::direct_flag | static_cast<std::uint32_t>(next_free);
+                    continue;
+                }
+
+                bool placed = false;
+                for (std::uint32_t seed = 0; seed < max_displacement && !placed; ++seed)
+                {
+                    candidate.clear();
+                    placed = true;
+                    for (size_t k = 0; k < size && placed; ++k)
+                    {
+                        const std::uint64_t slot = header.slot_of(hashes[bucket_items[first + k]], seed);
+                        placed = !taken[slot] && std::find(candidate.begin(), candidate.end(), slot) == candidate.end();
+                        candidate.push_back(slot);
+                    }
+                    if (placed)
+                    {
+                        seeds[b] = seed;
+                        for (size_t k = 0; k < size; ++k)
+                        {
+                            taken[candidate[k]] = true;
+                            slot_of_item[bucket_items[first + k]] = candidate[k];
+                        }
+                    }
+                }
+                if (!placed)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    };
+
+    /**
+     * @brief Reader of the perfect hash table format, it works in place on the bytes (for example a MappedFile).
+     * 
+     * @tparam K Key datatype (std::string or std::string_view for string keys).
+     * @tparam V Value datatype, values are unserialized on request (std::string_view values point into the bytes).
+     */
+    template <typename K, typename V>
+    class PerfectHashTable
+    {
+    public:
+        using key_view = typename std::conditional<std::is_same<K, std::string>::value, std::string_view, K>::type;
+
+        PerfectHashTable() : header(), seeds(nullptr), slots(nullptr), records(nullptr) {}
+
+        /**
+         * @brief Get a view of a serialized table, the bytes must stay alive while the view is used.
+         * 
+         * @param data Pointer to the serialized table.
+         * @param size Size of the serialized table.
+         * @return PerfectHashTable View of the table.
+         */
+        static PerfectHashTable from(const void *data, size_t size)
+        {
+            const unsigned char *bytes = static_cast<const unsigned char *>(data);
+            PerfectHashTable table;
+            if (size < sizeof(PerfectHashHeader))
+            {
+                throw std::runtime_error("Error while reading perfect hash table, data size is too small to be parsed.");
+            }
+            std::memcpy(&table.header, bytes, sizeof(PerfectHashHeader));
+            if (table.header.magic != PerfectHashHeader::magic_value || table.header.version != PerfectHashHeader::version_value)
+            {
+                throw std::runtime_error("Error while reading perfect hash table, unknown format.");
+            }
+            if (table.header.signature != PerfectHashHeader::signature_of<K, V>())
+            {
+                throw std::runtime_error("Error while reading perfect hash table, key/value types are different from the serialized ones.");
+            }
+            // Bounds are checked before computing the offsets of the sections, so a corrupted count can't overflow them.
+            const size_t available = size - sizeof(PerfectHashHeader);
+            if (table.header.bucket_count == 0 || table.header.bucket_count > table.header.count / 3 + 1 ||
+                table.header.count >= PerfectHashHeader::direct_flag || table.header.bucket_count > available / sizeof(std::uint32_t) ||
+                table.header.count > available / sizeof(std::uint64_t))
+            {
+                throw std::runtime_error("Error while reading perfect hash table, bucket or key count do not match the data size.");
+            }
+            size_t position = sizeof(PerfectHashHeader);
+            table.seeds = bytes + position;
+            position += table.header.bucket_count * sizeof(std::uint32_t);
+            position += (8 - position % 8) % 8;
+            table.slots = bytes + position;
+            position += table.header.count * sizeof(std::uint64_t);
+            table.records = bytes + position;
+            if (position > size || table.header.records_size != size - position)
+            {
+                throw std::runtime_error("Error while reading perfect hash table, sections do not match the data size.");
+            }
+            return table;
+        }
+
+        /**
+         * @brief Open a table written with PerfectHashTableWriter::write, the file stays mapped while the table is alive.
+         * 
+         * @param path Path of the file.
+         * @return PerfectHashTable Table.
+         */
+        static PerfectHashTable open(const std::string &path)
+        {
+            auto file = std::make_shared<MappedFile>(MappedFile::open(path));
+            file->advise(MADV_RANDOM);
+            PerfectHashTable table = from(file->data(), file->size());
+            table.mapping = std::move(file);
+            return table;
+        }
+
+        size_t size() const
+        {
+            return header.count;
+        }
+
+        bool empty() const
+        {
+            return header.count == 0;
+        }
+
+        /**
+         * @brief Get the serialized bytes of the value of a key.
+         * 
+         * @param key Key to search.
+         * @return std::string_view Bytes of the value, a null view (data() == nullptr) when the key is not in the table.
+         */
+        std::string_view value_bytes(const key_view &key) const
+        {
+            if (header.count == 0)
+            {
+                return std::string_view();
+            }
+            typename PerfectHashKey<key_view>::buffer_type buffer;
+            const std::string_view key_bytes = PerfectHashKey<key_view>::bytes(key, buffer);
+            const std::uint64_t hash = XXHash64::hash(key_bytes.data(), key_bytes.size(), header.seed);
+            std::uint32_t bucket_seed;
+            std::memcpy(&bucket_seed, seeds + header.bucket_of(hash) * sizeof(std::uint32_t), sizeof(bucket_seed));
+            const std::uint64_t slot_index = header.slot_of(hash, bucket_seed);
+            if (slot_index >= header.count)
+            {
+                return std::string_view();
+            }
+            std::uint64_t slot;
+            std::memcpy(&slot, slots + slot_index * sizeof(std::uint64_t), sizeof(slot));
+            if ((slot >> 48) != PerfectHashHeader::tag_of(hash))
+            {
+                return std::string_view();
+            }
+
+            const std::uint64_t offset = slot & PerfectHashHeader::offset_mask;
+            std::string_view key_stored = field(offset);
+            if (key_stored != key_bytes)
+            {
+                return std::string_view();
+            }
+            return field(offset + sizeof(std::uint32_t) + key_stored.size());
+        }
+
+        /**
+         * @brief Check if the key is in the table.
+         * 
+         * @param key Key to search.
+         * @return true Key found.
+         * @return false Key not found.
+         */
+        bool contains(const key_view &key) const
+        {
+            return value_bytes(key).data() != nullptr;
+        }
+
+        /**
+         * @brief Search a key and unserialize its value.
+         * 
+         * @param key Key to search.
+         * @param result Reference to the object where the value will be stored.
+         * @return true Key found, result has its value.
+         * @return false Key not found, result is untouched.
+         */
+        bool get(const key_view &key, V &result) const
+        {
+            const std::string_view bytes = value_bytes(key);
+            if (bytes.data() == nullptr)
+            {
+                return false;
+            }
+            TypeUnserializer::apply(result, reinterpret_cast<unsigned char *>(const_cast<char *>(bytes.data())), bytes.size());
+            return true;
+        }
+
+    private:
+        PerfectHashHeader header;
+        const unsigned char *seeds;
+        const unsigned char *slots;
+        const unsigned char *records;
+        std::shared_ptr<MappedFile> mapping;
+
+        /**
+         * @brief Read a size prefixed field of a record.
+         * 
+         * @param offset Offset of the field inside the records section.
+         * @return std::string_view Bytes of the field.
+         */
+        std::string_view field(std::uint64_t offset) const
+        {
+            std::uint32_t size;
+            if (offset + sizeof(size) > header.records_size)
+            {
+                throw std::runtime_error("Error while reading perfect hash table, record offset is out of the data.");
+            }
+            std::memcpy(&size, records + offset, sizeof(size));
+            if (size > header.records_size - offset - sizeof(size))
+            {
+                throw std::runtime_error("Error while reading perfect hash table, record is bigger than the data.");
+            }
+            return std::string_view(reinterpret_cast<const char *>(records + offset + sizeof(size)), size);
+        }
+    };
+};
@@ -0,0 +1,190 @@
+#pragma once
+
+#include "../Metaserializer.hpp"
+#include "FileSink.hpp"
+#include "MappedFile.hpp"
+#include "Records.hpp"
+#include <unordered_map>
+#include <vector>
+
+namespace Metaserializer
+{
+    /**
+     * @brief Compaction of a log of framed records keyed by the field I: only the latest record of every key is kept. A first pass reads
+     * the key of every record (the fields before it are skipped, see Unserialize<>::offset_of, and strings are views into the log) into
+     * a hash index of the offset of its latest record, a second sequential pass copies the framed bytes of those records, so the records
+     * are never decoded and the kept records stay in the order of the log. Floating point keys are compared in canonical form (see
+     * CanonicalObject), so -0.0 is the key 0.0 and every NaN is the same key.
+     * 
+     * @tparam I Index of the key field, an arithmetic, enum or string datatype.
+     * @tparam TArgs Datatypes given to Serialize<>::apply for every record.
+     */
+    template <size_t I, typename... TArgs>
+    class RecordCompaction
+    {
+    public:
+        using field_t = typename std::tuple_element<I, std::tuple<TArgs...>>::type;
+        using key_t = typename std::conditional<std::is_same<field_t, std::string>::value, std::string_view, field_t>::type;
+
+        static_assert(std::is_arithmetic<field_t>::value || std::is_enum<field_t>::value || std::is_same<key_t, std::string_view>::value,
+                      "Compaction keys must be arithmetic, enum or string fields.");
+        static_assert(!std::is_same<field_t, long double>::value, "Compaction keys can't be long double.");
+
+        /**
+         * @brief Write the latest record of every key of the log into a sink.
+         * 
+         * @tparam Sink Datatype of the sink (StringSink, FileSink, MappedSink, LargeBuffer...).
+         * @param log Framed records, from the oldest to the newest.
+         * @param sink Destination of the compacted log.
+         * @return size_t Number of records kept.
+         */
+        template <typename Sink>
+        static size_t apply(std::string_view log, Sink &sink)
+        {
+            return apply(log, sink, [](std::string_view) { return false; });
+        }
+
+        /**
+         * @brief Same as apply(log, sink) but the keys whose latest record is a tombstone are removed.
+         * 
+         * @tparam Sink Datatype of the sink.
+         * @tparam F Datatype of the function, called as f(std::string_view record) -> bool.
+         * @param log Framed records, from the oldest to the newest.
+         * @param sink Destination of the compacted log.
+         * @param deleted Function which returns true when the latest record of a key is a tombstone.
+         * @return size_t Number of records kept.
+         */
+        template <typename Sink, typename F>
+        static size_t apply(std::string_view log, Sink &sink, F &&deleted)
+        {
+            std::unordered_map<index_t, std::uint64_t> latest;
+            RecordReader reader(log);
+            std::string_view record;
+            std::uint64_t offset = 0;
+            while (reader.next(record))
+            {
+                latest[index_key(key(record))] = offset;
+                offset = reader.offset();
+            }
+
+            size_t count = 0;
+            reader = RecordReader(log);
+            offset = 0;
+            while (reader.next(record))
+            {
+                const auto found = latest.find(index_key(key(record)));
+                if (found != latest.end() && found->second == offset && !deleted(record))
+                {
+                    const size_t framed = sizeof(record_size_t) + record.size();
+                    std::memcpy(sink.reserve(framed), log.data() + offset, framed);
+                    sink.commit(framed);
+                    ++count;
+                }
+                offset = reader.offset();
+            }
+            return count;
+        }
+
+        /**
+         * @brief Compact a log file. The log is memory mapped and read sequentially, the compacted log is written to a temporary
+         * file which is synced and renamed to the output, so the output can be the log itself.
+         * 
+         * @param path Path of the log.
+         * @param output Path of the compacted log.
+         * @return size_t Number of records kept.
+         */
+        static size_t files(const std::string &path, const std::string &output)
+        {
+            return files(path, output, [](std::string_view) { return false; });
+        }
+
+        /**
+         * @brief Same as files(path, output) but the keys whose latest record is a tombstone are removed.
+         * 
+         */
+        template <typename F>
+        static size_t files(const std::string &path, const std::string &output, F &&deleted)
+        {
+            const MappedFile file = MappedFile::open(path);
+            file.advise(MADV_SEQUENTIAL);
+            const std::string_view log(reinterpret_cast<const char *>(file.data()), file.size());
+
+            const std::string temporary = output + ".tmp";
+            const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0)
+            {
+                throw std::runtime_error("Error while compacting log, can't open " + temporary + ": " + std::strerror(errno));
+            }
+
+            size_t count;
+            try
+            {
+                FileSink sink(fd);
+                count = apply(log, sink, deleted);
+                sink.flush();
+                if (::fsync(fd) != 0)
+                {
+                    throw std::runtime_error(std::string("Error while compacting log, can't sync: ") + std::strerror(errno));
+                }
+            }
+            catch (...)
+            {
+                ::close(fd);
+                ::unlink(temporary.c_str());
+                throw;
+            }
+
+            if (::close(fd) != 0 || ::rename(temporary.c_str(), output.c_str()) != 0)
+            {
+                const int error = errno;
+                ::unlink(temporary.c_str());
+                throw std::runtime_error("Error while compacting log to " + output + ": " + std::strerror(error));
+            }
+            return count;
+        }
+
+    private:
+        using index_t = typename std::conditional<std::is_floating_point<field_t>::value,
+                                                  typename std::conditional<sizeof(field_t) == 4, std::uint32_t, std::uint64_t>::type, key_t>::type;
+
+        /**
+         * @brief Key of the hash index, the canonical bytes of floating points and the key itself otherwise.
+         * 
+         */
+        static index_t index_key(const key_t &value)
+        {
+            if constexpr (std::is_floating_point<field_t>::value)
+            {
+                unsigned char bytes[sizeof(field_t)];
+                CanonicalObject<field_t>::copy(value, bytes);
+                index_t bits;
+                std::memcpy(&bits, bytes, sizeof(bits));
+                return bits;
+            }
+            else
+            {
+                return value;
+            }
+        }
+
+        /**
+         * @brief Read the key from the record bytes, strings are views into the record.
+         * 
+         */
+        static key_t key(std::string_view record)
+        {
+            const size_t offset = Unserialize<>::offset_of<I, TArgs...>(record);
+            unsigned char *bytes = Unserialize<>::raw_bytes(record) + offset;
+            key_t value;
+            if constexpr (std::is_same<key_t, std::string_view>::value)
+            {
+                ComplexObject<std::string_view, false>::unserialize(value, bytes, record.size() - offset);
+            }
+            else
+            {
+                TypeUnserializer::apply(value, bytes, record.size() - offset);
+            }
+            return value;
+        }
+    };
+};
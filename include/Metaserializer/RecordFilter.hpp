@@ -0,0 +1,174 @@
+#pragma once
+
+#include "../Metaserializer.hpp"
+#include "Records.hpp"
+#include <functional>
+#include <vector>
+
+namespace Metaserializer
+{
+    /**
+     * @brief Filter of framed records evaluated on the serialized bytes: every predicate reads only its field (the fields before it are
+     * skipped, see Unserialize<>::offset_of) and strings are compared as views into the record, so the records which don't match are
+     * never decoded. The predicates are combined with "and" and evaluated in the order they were added.
+     * 
+     * @tparam TArgs Datatypes given to Serialize<>::apply for every record.
+     */
+    template <typename... TArgs>
+    class RecordFilter
+    {
+    public:
+        template <size_t I>
+        using field_t = typename std::tuple_element<I, std::tuple<TArgs...>>::type;
+
+        /**
+         * @brief Keep the records where the field I is equal to the value.
+         * 
+         * @tparam I Index of the field.
+         * @param value Value compared, strings are given as std::string_view.
+         * @return RecordFilter& The filter.
+         */
+        template <size_t I, typename V>
+        RecordFilter &equal(const V &value)
+        {
+            predicates.push_back([value](std::string_view record) { return field<I>(record) == value; });
+            return *this;
+        }
+
+        /**
+         * @brief Keep the records where the field I is in the range [min, max].
+         * 
+         * @tparam I Index of the field.
+         * @param min Smallest value accepted.
+         * @param max Biggest value accepted.
+         * @return RecordFilter& The filter.
+         */
+        template <size_t I, typename V>
+        RecordFilter &range(const V &min, const V &max)
+        {
+            predicates.push_back([min, max](std::string_view record) {
+                const auto value = field<I>(record);
+                return !(value < min) && !(max < value);
+            });
+            return *this;
+        }
+
+        /**
+         * @brief Keep the records where the string field I starts with the prefix.
+         * 
+         * @tparam I Index of the field.
+         * @param prefix Prefix compared.
+         * @return RecordFilter& The filter.
+         */
+        template <size_t I>
+        RecordFilter &prefix(const std::string &prefix)
+        {
+            static_assert(IsString<field_t<I>>::value, "Prefix filters need a string field.");
+            predicates.push_back([prefix](std::string_view record) { return field<I>(record).substr(0, prefix.size()) == prefix; });
+            return *this;
+        }
+
+        /**
+         * @brief Keep the records where the function returns true, it receives the field I (strings as std::string_view).
+         * 
+         * @tparam I Index of the field.
+         * @tparam F Datatype of the function.
+         * @param f Function called with the field.
+         * @return RecordFilter& The filter.
+         */
+        template <size_t I, typename F>
+        RecordFilter &where(F f)
+        {
+            predicates.push_back([f](std::string_view record) { return f(field<I>(record)); });
+            return *this;
+        }
+
+        /**
+         * @brief Check if the record matches every predicate.
+         * 
+         * @param record Bytes of one record (without its size).
+         * @return true The record matches.
+         */
+        bool matches(std::string_view record) const
+        {
+            for (const auto &predicate : predicates)
+            {
+                if (!predicate(record))
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        /**
+         * @brief Call the function with every record of the batch which matches.
+         * 
+         * @tparam F Datatype of the function, called as f(std::string_view record).
+         * @param batch Batch of framed records.
+         * @param f Function called with the bytes of every record which matches.
+         * @return size_t Number of records which match.
+         */
+        template <typename F>
+        size_t for_each(std::string_view batch, F &&f) const
+        {
+            RecordReader reader(batch);
+            std::string_view record;
+            size_t count = 0;
+            while (reader.next(record))
+            {
+                if (matches(record))
+                {
+                    f(record);
+                    ++count;
+                }
+            }
+            return count;
+        }
+
+        /**
+         * @brief Get the records of the batch which match, as views into the batch.
+         * 
+         * @param batch Batch of framed records.
+         * @param out Vector where the records are added, they can be decoded with Unserialize<>::apply.
+         * @return size_t Number of records which match.
+         */
+        size_t apply(std::string_view batch, std::vector<std::string_view> &out) const
+        {
+            return for_each(batch, [&out](std::string_view record) { out.push_back(record); });
+        }
+
+    private:
+        template <typename T>
+        struct IsString
+        {
+            static const bool value = std::is_same<T, std::string>::value || std::is_same<T, std::string_view>::value;
+        };
+
+        std::vector<std::function<bool(std::string_view)>> predicates;
+
+        /**
+         * @brief Read the field I from the record bytes, strings are views into the record.
+         * 
+         */
+        template <size_t I>
+        static auto field(std::string_view record)
+        {
+            static_assert(!std::is_array<field_t<I>>::value, "Array fields can't be filtered.");
+            const size_t offset = Unserialize<>::offset_of<I, TArgs...>(record);
+            unsigned char *bytes = Unserialize<>::raw_bytes(record) + offset;
+            if constexpr (IsString<field_t<I>>::value)
+            {
+                std::string_view value;
+                ComplexObject<std::string_view, false>::unserialize(value, bytes, record.size() - offset);
+                return value;
+            }
+            else
+            {
+                field_t<I> value;
+                TypeUnserializer::apply(value, bytes, record.size() - offset);
+                return value;
+            }
+        }
+    };
+};
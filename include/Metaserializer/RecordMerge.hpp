@@ -0,0 +1,214 @@
+#pragma once
+
+#include "../Metaserializer.hpp"
+#include "FileSink.hpp"
+#include "MappedFile.hpp"
+#include "Records.hpp"
+#include <functional>
+#include <vector>
+
+namespace Metaserializer
+{
+    /**
+     * @brief K-way merge of batches of framed records sorted by the field I. Only the key is read from every record (the fields before
+     * it are skipped, see Unserialize<>::offset_of, and strings are views into the record), the inputs are merged with a loser tree
+     * (log2(k) comparisons per record) and the framed bytes are copied verbatim to the output, so the records are never decoded.
+     * Records with equal keys keep the order of the inputs (stable).
+     * 
+     * @tparam I Index of the key field.
+     * @tparam TArgs Datatypes given to Serialize<>::apply for every record.
+     */
+    template <size_t I, typename... TArgs>
+    class RecordMerge
+    {
+    public:
+        using field_t = typename std::tuple_element<I, std::tuple<TArgs...>>::type;
+        using key_t = typename std::conditional<std::is_same<field_t, std::string>::value, std::string_view, field_t>::type;
+
+        /**
+         * @brief Merge sorted batches into a sink.
+         * 
+         * @tparam Sink Datatype of the sink (StringSink, FileSink, MappedSink, LargeBuffer...).
+         * @tparam Compare Datatype of the comparison of the keys.
+         * @param batches Batches of framed records, every one sorted by the key.
+         * @param sink Destination of the merged records.
+         * @param compare Strict weak ordering of the keys used to sort the batches.
+         * @return size_t Number of records written.
+         */
+        template <typename Sink, typename Compare = std::less<key_t>>
+        static size_t apply(const std::vector<std::string_view> &batches, Sink &sink, Compare compare = Compare())
+        {
+            static_assert(!std::is_array<field_t>::value, "Array fields can't be merge keys.");
+            std::vector<Input> inputs;
+            inputs.reserve(batches.size());
+            for (std::string_view batch : batches)
+            {
+                inputs.emplace_back(batch);
+                advance(inputs.back(), inputs.size() - 1, compare);
+            }
+            if (inputs.empty())
+            {
+                return 0;
+            }
+
+            const size_t k = inputs.size();
+            auto wins = [&inputs, &compare](size_t a, size_t b) {
+                if (inputs[a].done || inputs[b].done)
+                {
+                    return !inputs[a].done;
+                }
+                if (compare(inputs[a].key, inputs[b].key))
+                {
+                    return true;
+                }
+                return !compare(inputs[b].key, inputs[a].key) && a < b;
+            };
+
+            // Leaves are the nodes k..2k-1 and the internal node n keeps the loser of its children 2n and 2n+1, losers[0] is the winner.
+            std::vector<size_t> losers(k), winners(2 * k);
+            for (size_t i = 0; i < k; ++i)
+            {
+                winners[k + i] = i;
+            }
+            for (size_t node = k - 1; node >= 1; --node)
+            {
+                const size_t left = winners[2 * node], right = winners[2 * node + 1];
+                const bool left_wins = wins(left, right);
+                winners[node] = left_wins ? left : right;
+                losers[node] = left_wins ? right : left;
+            }
+            losers[0] = k > 1 ? winners[1] : 0;
+
+            size_t count = 0;
+            while (!inputs[losers[0]].done)
+            {
+                size_t winner = losers[0];
+                Input &input = inputs[winner];
+                const size_t framed = sizeof(record_size_t) + input.record.size();
+                std::memcpy(sink.reserve(framed), input.record.data() - sizeof(record_size_t), framed);
+                sink.commit(framed);
+                ++count;
+
+                advance(input, winner, compare);
+                for (size_t node = (winner + k) / 2; node >= 1; node /= 2)
+                {
+                    if (wins(losers[node], winner))
+                    {
+                        std::swap(losers[node], winner);
+                    }
+                }
+                losers[0] = winner;
+            }
+            return count;
+        }
+
+        /**
+         * @brief Merge sorted files of framed records (e.g. written with RecordWriter and a FileSink) into a new file. The inputs
+         * are memory mapped and read sequentially, the merge is written to a temporary file which is synced and renamed to the
+         * output, so the output can be one of the inputs.
+         * 
+         * @tparam Compare Datatype of the comparison of the keys.
+         * @param paths Paths of the sorted files.
+         * @param output Path of the merged file, created or replaced.
+         * @param compare Strict weak ordering of the keys used to sort the files.
+         * @return size_t Number of records written.
+         */
+        template <typename Compare = std::less<key_t>>
+        static size_t files(const std::vector<std::string> &paths, const std::string &output, Compare compare = Compare())
+        {
+            std::vector<MappedFile> files;
+            std::vector<std::string_view> batches;
+            files.reserve(paths.size());
+            for (const std::string &path : paths)
+            {
+                files.push_back(MappedFile::open(path));
+                files.back().advise(MADV_SEQUENTIAL);
+                batches.emplace_back(reinterpret_cast<const char *>(files.back().data()), files.back().size());
+            }
+
+            const std::string temporary = output + ".tmp";
+            const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0)
+            {
+                throw std::runtime_error("Error while merging records, can't open " + temporary + ": " + std::strerror(errno));
+            }
+            size_t count;
+            try
+            {
+                FileSink sink(fd);
+                count = apply(batches, sink, compare);
+                sink.flush();
+                if (::fsync(fd) != 0)
+                {
+                    throw std::runtime_error(std::string("Error while merging records, can't sync: ") + std::strerror(errno));
+                }
+            }
+            catch (...)
+            {
+                ::close(fd);
+                ::unlink(temporary.c_str());
+                throw;
+            }
+
+            if (::close(fd) != 0 || ::rename(temporary.c_str(), output.c_str()) != 0)
+            {
+                const int error = errno;
+                ::unlink(temporary.c_str());
+                throw std::runtime_error("Error while merging records to " + output + ": " + std::strerror(error));
+            }
+            return count;
+        }
+
+    private:
+        struct Input
+        {
+            explicit Input(std::string_view batch) : reader(batch), key(), done(false) {}
+
+            RecordReader reader;
+            std::string_view record;
+            key_t key;
+            bool done;
+        };
+
+        /**
+         * @brief Read the next record of the input and its key, the input must stay sorted.
+         * 
+         */
+        template <typename Compare>
+        static void advance(Input &input, size_t index, Compare &compare)
+        {
+            const bool first = input.record.data() == nullptr;
+            if (!input.reader.next(input.record))
+            {
+                input.done = true;
+                return;
+            }
+            key_t next = key(input.record);
+            if (!first && compare(next, input.key))
+            {
+                throw std::runtime_error("Error while merging records, input " + std::to_string(index) + " is not sorted.");
+            }
+            input.key = std::move(next);
+        }
+
+        /**
+         * @brief Read the key from the record bytes, strings are views into the record.
+         * 
+         */
+        static key_t key(std::string_view record)
+        {
+            const size_t offset = Unserialize<>::offset_of<I, TArgs...>(record);
+            unsigned char *bytes = Unserialize<>::raw_bytes(record) + offset;
+            key_t value;
+            if constexpr (std::is_same<key_t, std::string_view>::value)
+            {
+                ComplexObject<std::string_view, false>::unserialize(value, bytes, record.size() - offset);
+            }
+            else
+            {
+                TypeUnserializer::apply(value, bytes, record.size() - offset);
+            }
+            return value;
+        }
+    };
+};
@@ -0,0 +1,170 @@
+#pragma once
+
+#include "../Metaserializer.hpp"
+#include "Records.hpp"
+#include <vector>
+
+namespace Metaserializer
+{
+    /**
+     * @brief Sort of a batch of framed records by the field I without decoding them. The key of every record is read from its bytes
+     * (the fields before it are skipped, see Unserialize<>::offset_of) into a (key, offset) array, the array is sorted with a LSD radix
+     * sort (one pass per key byte, the passes where every key has the same byte are skipped) and the framed bytes are gathered in order.
+     * The sort is stable.
+     * 
+     * @tparam I Index of the key field, an integral, enum or floating point datatype.
+     * @tparam TArgs Datatypes given to Serialize<>::apply for every record.
+     */
+    template <size_t I, typename... TArgs>
+    class RecordSort
+    {
+    public:
+        using field_t = typename std::tuple_element<I, std::tuple<TArgs...>>::type;
+
+        static_assert(std::is_arithmetic<field_t>::value || std::is_enum<field_t>::value, "Radix sort needs an arithmetic or enum key.");
+        static_assert(sizeof(field_t) <= 8, "Radix sort keys have at most 8 bytes.");
+
+        /**
+         * @brief Get the records of the batch sorted by the key, as views into the batch.
+         * 
+         * @param batch Batch of framed records.
+         * @param out Vector where the records are added, they can be decoded with Unserialize<>::apply.
+         * @param descending Sort from the biggest key to the smallest.
+         * @return size_t Number of records.
+         */
+        static size_t order(std::string_view batch, std::vector<std::string_view> &out, bool descending = false)
+        {
+            const std::vector<Entry> entries = sort(batch, descending);
+            out.reserve(out.size() + entries.size());
+            for (const Entry &entry : entries)
+            {
+                out.push_back(record(batch, entry.offset));
+            }
+            return entries.size();
+        }
+
+        /**
+         * @brief Write the records of the batch sorted by the key into a sink, the framed bytes are copied verbatim.
+         * 
+         * @tparam Sink Datatype of the sink (StringSink, FileSink, MappedSink, LargeBuffer...).
+         * @param batch Batch of framed records.
+         * @param sink Destination of the sorted records.
+         * @param descending Sort from the biggest key to the smallest.
+         * @return size_t Number of records.
+         */
+        template <typename Sink>
+        static size_t apply(std::string_view batch, Sink &sink, bool descending = false)
+        {
+            const std::vector<Entry> entries = sort(batch, descending);
+            const size_t distance = Prefetch::distance().load(std::memory_order_relaxed);
+            for (size_t i = 0; i < entries.size(); ++i)
+            {
+                if (distance > 0 && i + distance < entries.size())
+                {
+                    const std::string_view ahead = record(batch, entries[i + distance].offset);
+                    Prefetch::read_range(ahead.data(), ahead.size());
+                }
+                const std::string_view bytes = record(batch, entries[i].offset);
+                const size_t framed = sizeof(record_size_t) + bytes.size();
+                std::memcpy(sink.reserve(framed), bytes.data() - sizeof(record_size_t), framed);
+                sink.commit(framed);
+            }
+            return entries.size();
+        }
+
+    private:
+        using key_t = typename std::conditional<sizeof(field_t) <= 1, std::uint8_t,
+                                                typename std::conditional<sizeof(field_t) <= 2, std::uint16_t,
+                                                                          typename std::conditional<sizeof(field_t) <= 4, std::uint32_t, std::uint64_t>::type>::type>::type;
+
+        struct Entry
+        {
+            key_t key;
+            std::uint64_t offset; //< Offset of the record size in the batch.
+        };
+
+        /**
+         * @brief Unsigned key with the order of the field: the sign bit of signed integers is flipped, negative floating points
+         * have every bit flipped and positive ones the sign bit.
+         * 
+         */
+        static key_t radix_key(const field_t &value)
+        {
+            using integer_t = typename std::conditional<std::is_enum<field_t>::value, std::underlying_type<field_t>, std::enable_if<true, field_t>>::type::type;
+            key_t bits;
+            std::memcpy(&bits, &value, sizeof(key_t));
+            const key_t sign = static_cast<key_t>(key_t(1) << (sizeof(key_t) * 8 - 1));
+            if constexpr (std::is_floating_point<integer_t>::value)
+            {
+                return (bits & sign) ? static_cast<key_t>(~bits) : static_cast<key_t>(bits | sign);
+            }
+            else if constexpr (std::is_signed<integer_t>::value)
+            {
+                return static_cast<key_t>(bits ^ sign);
+            }
+            else
+            {
+                return bits;
+            }
+        }
+
+        static std::string_view record(std::string_view batch, std::uint64_t offset)
+        {
+            record_size_t size;
+            std::memcpy(&size, batch.data() + offset, sizeof(record_size_t));
+            return batch.substr(offset + sizeof(record_size_t), size);
+        }
+
+        static std::vector<Entry> sort(std::string_view batch, bool descending)
+        {
+            std::vector<Entry> entries;
+            RecordReader reader(batch);
+            std::string_view bytes;
+            size_t offset = 0;
+            while (reader.next(bytes))
+            {
+                const size_t field = Unserialize<>::offset_of<I, TArgs...>(bytes);
+                field_t value;
+                TypeUnserializer::apply(value, Unserialize<>::raw_bytes(bytes) + field, bytes.size() - field);
+                const key_t key = radix_key(value);
+                entries.push_back(Entry{descending ? static_cast<key_t>(~key) : key, offset});
+                offset = reader.offset();
+            }
+
+            // Histograms of every key byte in one pass, then one stable counting pass per byte from the least significant one.
+            const size_t passes = sizeof(key_t);
+            std::vector<size_t> counts(passes * 256, 0);
+            for (const Entry &entry : entries)
+            {
+                for (size_t pass = 0; pass < passes; ++pass)
+                {
+                    ++counts[pass * 256 + ((entry.key >> (pass * 8)) & 0xff)];
+                }
+            }
+
+            std::vector<Entry> buffer(entries.size());
+            for (size_t pass = 0; pass < passes; ++pass)
+            {
+                size_t *count = counts.data() + pass * 256;
+                const size_t shift = pass * 8;
+                if (entries.empty() || count[(entries.front().key >> shift) & 0xff] == entries.size())
+                {
+                    continue;
+                }
+                size_t position = 0;
+                for (size_t digit = 0; digit < 256; ++digit)
+                {
+                    const size_t n = count[digit];
+                    count[digit] = position;
+                    position += n;
+                }
+                for (const Entry &entry : entries)
+                {
+                    buffer[count[(entry.key >> shift) & 0xff]++] = entry;
+                }
+                entries.swap(buffer);
+            }
+            return entries;
+        }
+    };
+};
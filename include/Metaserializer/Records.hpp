@@ -0,0 +1,178 @@
+#pragma once
+
+#include "../Metaserializer.hpp"
+#include <vector>
+
+/**
+ * @brief Stream of framed records: every record is the output of Serialize<>::apply preceded by its size, so a batch (a file,
+ * a network buffer...) can be walked record by record without decoding them.
+ * 
+ * [u32 size][record bytes][u32 size][record bytes]...
+ */
+namespace Metaserializer
+{
+    typedef std::uint32_t record_size_t;
+
+    /**
+     * @brief Writer of framed records into a sink (StringSink, FileSink, MappedSink, LargeBuffer...).
+     * 
+     */
+    struct RecordWriter
+    {
+        /**
+         * @brief Write one record with the objects given.
+         * 
+         * @tparam Sink Datatype of the sink.
+         * @tparam TArgs Datatypes serialized in the record.
+         * @param sink Destination of the bytes.
+         * @param args Objects serialized in the record.
+         * @return size_t Number of bytes written, including the size.
+         */
+        template <typename Sink, typename... TArgs>
+        static size_t append(Sink &sink, TArgs &...args)
+        {
+            const size_t size = Serialize<>::size(args...);
+            if (size > std::numeric_limits<record_size_t>::max())
+            {
+                throw std::runtime_error("Error while writing record, record size does not fit in record_size_t.");
+            }
+            const record_size_t record_size = static_cast<record_size_t>(size);
+            std::memcpy(sink.reserve(sizeof(record_size_t)), &record_size, sizeof(record_size_t));
+            sink.commit(sizeof(record_size_t));
+            return sizeof(record_size_t) + Serialize<>::to(sink, args...);
+        }
+    };
+
+    /**
+     * @brief Reader of the records of a batch, the records are views into the bytes given.
+     * 
+     */
+    class RecordReader
+    {
+    public:
+        explicit RecordReader(std::string_view bytes) : bytes(bytes), position(0) {}
+
+        /**
+         * @brief Get the next record.
+         * 
+         * @param record View of the record bytes (without the size).
+         * @return true There was a record.
+         * @return false End of the batch.
+         */
+        bool next(std::string_view &record)
+        {
+            if (position == bytes.size())
+            {
+                return false;
+            }
+            record_size_t size;
+            if (bytes.size() - position < sizeof(record_size_t))
+            {
+                throw std::runtime_error("Error while reading record, truncated record size.");
+            }
+            std::memcpy(&size, bytes.data() + position, sizeof(record_size_t));
+            position += sizeof(record_size_t);
+            if (bytes.size() - position < size)
+            {
+                throw std::runtime_error("Error while reading record, truncated record.");
+            }
+            record = bytes.substr(position, size);
+            position += size;
+            return true;
+        }
+
+        /**
+         * @brief Offset of the next record in the batch.
+         * 
+         * @return size_t Offset in bytes.
+         */
+        size_t offset() const
+        {
+            return position;
+        }
+
+    private:
+        std::string_view bytes;
+        size_t position;
+    };
+
+    /**
+     * @brief Decode batches of records. A second reader walks Prefetch::distance() records ahead of the decoded one and prefetches
+     * their bytes, so decoding a batch bigger than the cache does not stall on every record.
+     * 
+     * @tparam T Datatype of every record.
+     */
+    template <typename T>
+    struct RecordBatch
+    {
+        /**
+         * @brief Decode every record into a reused object and call the function with it.
+         * 
+         * @tparam F Datatype of the function, called as f(const T&).
+         * @param bytes Batch of records.
+         * @param f Function called for every record.
+         * @return size_t Number of records.
+         */
+        template <typename F>
+        static size_t for_each(std::string_view bytes, F &&f)
+        {
+            T value;
+            return walk(bytes, [&value, &f](std::string_view record, size_t) {
+                Unserialize<>::apply(record, value);
+                f(static_cast<const T &>(value));
+            });
+        }
+
+        /**
+         * @brief Decode every record at the end of the vector.
+         * 
+         * @param bytes Batch of records.
+         * @param out Vector where the records are added.
+         * @return size_t Number of records.
+         */
+        static size_t decode(std::string_view bytes, std::vector<T> &out)
+        {
+            return walk(bytes, [&out](std::string_view record, size_t distance) {
+                if (distance > 0 && out.size() + distance < out.capacity())
+                {
+                    Prefetch::write(out.data() + out.size() + distance);
+                }
+                out.emplace_back();
+                try
+                {
+                    Unserialize<>::apply(record, out.back());
+                }
+                catch (...)
+                {
+                    out.pop_back();
+                    throw;
+                }
+            });
+        }
+
+    private:
+        template <typename F>
+        static size_t walk(std::string_view bytes, F &&decode_record)
+        {
+            const size_t distance = Prefetch::distance().load(std::memory_order_relaxed);
+            RecordReader lead(bytes), reader(bytes);
+            std::string_view ahead, record;
+            for (size_t i = 0; i < distance && lead.next(ahead); ++i)
+            {
+                Prefetch::read_range(ahead.data(), ahead.size());
+            }
+
+            size_t count = 0;
+            while (reader.next(record))
+            {
+                if (distance > 0 && lead.next(ahead))
+                {
+                    Prefetch::read_range(ahead.data(), ahead.size());
+                }
+                decode_record(record, distance);
+                ++count;
+            }
+            return count;
+        }
+    };
+};
@@ -0,0 +1,285 @@
+#pragma once
+
+#include "../Metaserializer.hpp"
+#include "FileSink.hpp"
+#include "MappedFile.hpp"
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+/**
+ * @brief Snapshot of the application state: a set of named root objects saved to a single file and restored from a memory mapping,
+ * so a restart decodes the state straight from the page cache instead of rebuilding it.
+ * 
+ * [header][section 0]...[section n-1][directory: u64 fingerprint, u64 offset, u64 size, u32 name size, name per section]
+ * Every section is the output of Serialize<>::apply for its root object and starts at a multiple of 64 bytes.
+ */
+namespace Metaserializer
+{
+    struct SnapshotHeader
+    {
+        char magic[4];
+        std::uint32_t version;
+        std::uint64_t section_count;
+        std::uint64_t directory_offset;
+        std::uint64_t directory_size;
+        unsigned char reserved[32];
+
+        static const std::uint32_t current_version = 1;
+        static const size_t alignment = 64;
+    };
+
+    static_assert(sizeof(SnapshotHeader) == SnapshotHeader::alignment, "Snapshot header must fill the first aligned block.");
+
+    /**
+     * @brief Set of root objects saved and restored together. The roots are registered by reference once and the snapshot
+     * writes them (save) or decodes into them (restore), strings decoded as std::string_view point into the file mapping which
+     * is kept alive by the snapshot while a root restored from it is not restored from another file.
+     * 
+     */
+    class Snapshot
+    {
+    public:
+        /**
+         * @brief Register a root object.
+         * 
+         * @tparam T Datatype of the root object.
+         * @param name Name of the section, unique in the snapshot.
+         * @param root Object saved and restored, it must outlive the snapshot.
+         */
+        template <typename T>
+        void add(const std::string &name, T &root)
+        {
+            for (const auto &section : sections)
+            {
+                if (section.name == name)
+                {
+                    throw std::runtime_error("Error while adding snapshot section, duplicated name " + name + ".");
+                }
+            }
+            sections.push_back({name, TypeHasher::fingerprint<typename HashAs<T>::type>(), &root, &save_as<T>, &decode_as<T>, &swap_as<T>, nullptr});
+        }
+
+        /**
+         * @brief Write every root object to the file. The snapshot is written to a temporary file which replaces the old one
+         * only when it is complete, so a crash while saving keeps the previous snapshot.
+         * 
+         * @param path Path of the snapshot file.
+         * @return size_t Size of the file.
+         */
+        size_t save(const std::string &path) const
+        {
+            const std::string temporary = path + ".tmp";
+            const int fd = ::open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+            if (fd < 0)
+            {
+                throw std::runtime_error("Error while saving snapshot, can't open " + temporary + ": " + std::strerror(errno));
+            }
+
+            size_t file_size;
+            try
+            {
+                file_size = write_file(fd);
+                if (::fsync(fd) != 0)
+                {
+                    throw std::runtime_error(std::string("Error while saving snapshot, can't sync: ") + std::strerror(errno));
+                }
+            }
+            catch (...)
+            {
+                ::close(fd);
+                ::unlink(temporary.c_str());
+                throw;
+            }
+
+            if (::close(fd) != 0 || ::rename(temporary.c_str(), path.c_str()) != 0)
+            {
+                const int error = errno;
+                ::unlink(temporary.c_str());
+                throw std::runtime_error("Error while saving snapshot to " + path + ": " + std::strerror(error));
+            }
+            return file_size;
+        }
+
+        /**
+         * @brief Decode the registered root objects from the file. Sections of the file which are not registered are ignored
+         * and registered roots missing in the file are left untouched (with the mapping they were restored from). Every section
+         * is decoded into a new object first and the roots are swapped with them only when all of them succeeded, so a failed
+         * restore leaves every root and its mapping as they were (at the cost of a second copy of the state while restoring).
+         * 
+         * @param path Path of the snapshot file.
+         * @return size_t Number of roots restored.
+         */
+        size_t restore(const std::string &path)
+        {
+            auto file = std::make_shared<MappedFile>(MappedFile::open(path));
+            file->advise(MADV_SEQUENTIAL);
+            file->advise(MADV_WILLNEED);
+
+            const unsigned char *bytes = file->data();
+            SnapshotHeader header;
+            if (file->size() < sizeof(SnapshotHeader))
+            {
+                throw std::runtime_error("Error while restoring snapshot, " + path + " is too small.");
+            }
+            std::memcpy(&header, bytes, sizeof(SnapshotHeader));
+            if (std::memcmp(header.magic, "MSSN", 4) != 0 || header.version != SnapshotHeader::current_version)
+            {
+                throw std::runtime_error("Error while restoring snapshot, " + path + " is not a snapshot file.");
+            }
+            if (header.directory_offset > file->size() || header.directory_size > file->size() - header.directory_offset)
+            {
+                throw std::runtime_error("Error while restoring snapshot, directory out of the file.");
+            }
+
+            std::vector<std::pair<Section *, std::string_view>> found;
+            size_t index = header.directory_offset;
+            const size_t end = header.directory_offset + header.directory_size;
+            for (std::uint64_t i = 0; i < header.section_count; ++i)
+            {
+                std::uint64_t entry[3];
+                std::uint32_t name_size;
+                if (end - index < sizeof(entry) + sizeof(name_size))
+                {
+                    throw std::runtime_error("Error while restoring snapshot, truncated directory.");
+                }
+                std::memcpy(entry, bytes + index, sizeof(entry));
+                std::memcpy(&name_size, bytes + index + sizeof(entry), sizeof(name_size));
+                index += sizeof(entry) + sizeof(name_size);
+                if (end - index < name_size)
+                {
+                    throw std::runtime_error("Error while restoring snapshot, truncated directory.");
+                }
+                const std::string_view name(reinterpret_cast<const char *>(bytes + index), name_size);
+                index += name_size;
+
+                Section *section = find(name);
+                if (section == nullptr)
+                {
+                    continue;
+                }
+                if (entry[0] != section->fingerprint)
+                {
+                    throw std::runtime_error("Error while restoring snapshot, section " + section->name + " was saved with a different type.");
+                }
+                if (entry[1] > file->size() || entry[2] > file->size() - entry[1])
+                {
+                    throw std::runtime_error("Error while restoring snapshot, section " + section->name + " out of the file.");
+                }
+                found.emplace_back(section, std::string_view(reinterpret_cast<const char *>(bytes + entry[1]), entry[2]));
+            }
+
+            std::vector<std::shared_ptr<void>> decoded;
+            decoded.reserve(found.size());
+            for (const auto &[section, section_bytes] : found)
+            {
+                decoded.push_back(section->decode(section_bytes));
+            }
+            for (size_t i = 0; i < found.size(); ++i)
+            {
+                found[i].first->swap(found[i].first->root, decoded[i].get());
+                found[i].first->mapping = file;
+            }
+            return found.size();
+        }
+
+    private:
+        struct Section
+        {
+            std::string name;
+            std::uint64_t fingerprint;
+            void *root;
+            size_t (*save)(FileSink &, void *);
+            std::shared_ptr<void> (*decode)(std::string_view);
+            void (*swap)(void *, void *);
+            std::shared_ptr<MappedFile> mapping; //< Bytes the views of the restored root point to.
+        };
+
+        std::vector<Section> sections;
+
+        template <typename T>
+        static size_t save_as(FileSink &sink, void *root)
+        {
+            return Serialize<>::to(sink, *static_cast<T *>(root));
+        }
+
+        template <typename T>
+        struct Decoded
+        {
+            T value;
+        };
+
+        template <typename T>
+        static std::shared_ptr<void> decode_as(std::string_view bytes)
+        {
+            auto decoded = std::make_shared<Decoded<T>>();
+            Unserialize<>::apply(bytes, decoded->value);
+            return decoded;
+        }
+
+        template <typename T>
+        static void swap_as(void *root, void *decoded)
+        {
+            using std::swap;
+            swap(*static_cast<T *>(root), static_cast<Decoded<T> *>(decoded)->value);
+        }
+
+        Section *find(std::string_view name)
+        {
+            for (auto &section : sections)
+            {
+                if (section.name == name)
+                {
+                    return &section;
+                }
+            }
+            return nullptr;
+        }
+
+        static void pad(FileSink &sink)
+        {
+            const size_t padding = (SnapshotHeader::alignment - sink.bytes_written() % SnapshotHeader::alignment) % SnapshotHeader::alignment;
+            std::memset(sink.reserve(padding), 0, padding);
+            sink.commit(padding);
+        }
+
+        size_t write_file(int fd) const
+        {
+            FileSink sink(fd);
+            std::memset(sink.reserve(sizeof(SnapshotHeader)), 0, sizeof(SnapshotHeader));
+            sink.commit(sizeof(SnapshotHeader));
+
+            std::vector<std::uint64_t> offsets, sizes;
+            for (const auto &section : sections)
+            {
+                pad(sink);
+                offsets.push_back(sink.bytes_written());
+                sizes.push_back(section.save(sink, section.root));
+            }
+
+            SnapshotHeader header = {};
+            std::memcpy(header.magic, "MSSN", 4);
+            header.version = SnapshotHeader::current_version;
+            header.section_count = sections.size();
+            header.directory_offset = sink.bytes_written();
+            for (size_t i = 0; i < sections.size(); ++i)
+            {
+                const std::uint64_t entry[3] = {sections[i].fingerprint, offsets[i], sizes[i]};
+                const std::uint32_t name_size = static_cast<std::uint32_t>(sections[i].name.size());
+                unsigned char *dest = sink.reserve(sizeof(entry) + sizeof(name_size) + name_size);
+                std::memcpy(dest, entry, sizeof(entry));
+                std::memcpy(dest + sizeof(entry), &name_size, sizeof(name_size));
+                std::memcpy(dest + sizeof(entry) + sizeof(name_size), sections[i].name.data(), name_size);
+                sink.commit(sizeof(entry) + sizeof(name_size) + name_size);
+            }
+            header.directory_size = sink.bytes_written() - header.directory_offset;
+            sink.flush();
+
+            if (::pwrite(fd, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)))
+            {
+                throw std::runtime_error(std::string("Error while saving snapshot, can't write header: ") + std::strerror(errno));
+            }
+            return sink.bytes_written();
+        }
+    };
+};
@@ -0,0 +1,469 @@
+#pragma once
+
+#include "../Metaserializer.hpp"
+#include <map>
+
+/**
+ * @brief Searchable encoding for sorted maps. Keys are stored in a fixed width array (or through offsets for string keys) so
+ * lower_bound/find run directly on the serialized bytes, values are serialized one by one and decoded only when requested.
+ * 
+ * [u64 signature][u32 count][u32 layout][u32 key width][u32 reserved]
+ * [keys: count fixed width keys | u32 key offsets[count + 1] + key bytes]
+ * [u32 value offsets[count + 1]][value bytes]
+ */
+namespace Metaserializer
+{
+    /**
+     * @brief Order of the keys inside the serialized map.
+     * 
+     */
+    enum class SortedMapLayout : std::uint32_t
+    {
+        sorted = 0,    //< Keys in ascending order, binary search.
+        eytzinger = 1, //< Keys in breadth first order of the search tree, cache friendly search but positions are not sorted.
+    };
+
+    /**
+     * @brief Key access of the serialized map, fixed width keys are read straight from the keys array.
+     * 
+     * @tparam K Key datatype.
+     */
+    template <typename K>
+    struct SortedMapKey
+    {
+        static_assert(IsSimpleObject<K>::value, "Sorted map keys must be trivially copyable or strings.");
+
+        using view_type = K;
+        static const bool fixed_width = true;
+
+        static K read(const unsigned char *keys, size_t index)
+        {
+            K key;
+            std::memcpy(&key, keys + index * sizeof(K), sizeof(K));
+            return key;
+        }
+    };
+
+    /**
+     * @brief String keys, stored as offsets to the key bytes and read as std::string_view.
+     * 
+     */
+    template <>
+    struct SortedMapKey<std::string_view>
+    {
+        using view_type = std::string_view;
+        static const bool fixed_width = false;
+
+        static std::string_view read(const unsigned char *keys, size_t index)
+        {
+            std::uint32_t begin, end;
+            std::memcpy(&begin, keys + index * sizeof(std::uint32_t), sizeof(std::uint32_t));
+            std::memcpy(&end, keys + (index + 1) * sizeof(std::uint32_t), sizeof(std::uint32_t));
+            return std::string_view(reinterpret_cast<const char *>(keys) + begin, end - begin);
+        }
+    };
+
+    template <>
+    struct SortedMapKey<std::string> : SortedMapKey<std::string_view>
+    {
+    };
+
+    /**
+     * @brief Signature of the key and value datatypes of a serialized map.
+     * 
+     * @tparam K Key datatype.
+     * @tparam V Value datatype.
+     * @return constexpr std::uint64_t Signature.
+     */
+    template <typename K, typename V>
+    constexpr std::uint64_t sorted_map_signature()
+    {
+        using key_type = typename HashAs<typename std::decay<K>::type>::type;
+        using value_type = typename HashAs<typename std::decay<V>::type>::type;
+        return (TypeHasher::fingerprint<key_type>() * 1099511628211ull) ^ TypeHasher::fingerprint<value_type>();
+    }
+
+    /**
+     * @brief Writer of the searchable map encoding.
+     * 
+     * @tparam BufferSize Buffer size of the Serialize<> used for the values, they are written through a StringSink so their size is not limited.
+     */
+    template <int BufferSize = 16384>
+    struct SortedMapWriter
+    {
+        static const size_t header_size = sizeof(std::uint64_t) + 4 * sizeof(std::uint32_t); //< Bytes before the keys.
+
+        /**
+         * @brief Serialize the map.
+         * 
+         * @tparam K Key datatype, trivially copyable with operator< or std::string.
+         * @tparam V Value datatype, anything the library can serialize.
+         * @tparam Compare Order of the map, std::less because SortedMapView searches with operator<.
+         * @param map Map to serialize.
+         * @param layout Order of the keys.
+         * @return std::string Serialized map.
+         */
+        template <typename K, typename V, typename Compare, typename Alloc>
+        static std::string build(const std::map<K, V, Compare, Alloc> &map, SortedMapLayout layout = SortedMapLayout::sorted)
+        {
+            static_assert(std::is_same<Compare, std::less<K>>::value || std::is_same<Compare, std::less<>>::value,
+                          "Sorted maps are searched with operator<, the map must be ordered with std::less.");
+            std::vector<typename std::map<K, V, Compare, Alloc>::const_iterator> order;
+            order.reserve(map.size());
+            for (auto it = map.begin(); it != map.end(); ++it)
+            {
+                order.push_back(it);
+            }
+            if (layout == SortedMapLayout::eytzinger)
+            {
+                order = eytzinger_order(order);
+            }
+
+            std::string result;
+            const std::uint64_t signature = sorted_map_signature<K, V>();
+            const std::uint32_t header[4] = {to_u32(map.size()), static_cast<std::uint32_t>(layout), SortedMapKey<K>::fixed_width ? static_cast<std::uint32_t>(sizeof(K)) : 0, 0};
+            result.append(reinterpret_cast<const char *>(&signature), sizeof(signature));
+            result.append(reinterpret_cast<const char *>(header), sizeof(header));
+
+            if constexpr (SortedMapKey<K>::fixed_width)
+            {
+                for (const auto &it : order)
+                {
+                    result.append(reinterpret_cast<const char *>(&it->first), sizeof(K));
+                }
+            }
+            else
+            {
+                std::uint32_t key_offset = to_u32(sizeof(std::uint32_t) * (order.size() + 1));
+                for (const auto &it : order)
+                {
+                    append_u32(result, key_offset);
+                    key_offset = to_u32(key_offset + it->first.size());
+                }
+                append_u32(result, key_offset);
+                for (const auto &it : order)
+                {
+                    result.append(it->first.data(), it->first.size());
+                }
+            }
+
+            const size_t value_offsets = result.size();
+            result.append(sizeof(std::uint32_t) * (order.size() + 1), '\0');
+            const size_t values = result.size();
+            StringSink sink(result);
+            for (size_t i = 0; i < order.size(); ++i)
+            {
+                // The serializers take non const references but they do not modify the value.
+                V &value = const_cast<V &>(order[i]->second);
+                const std::uint32_t offset = to_u32(result.size() - values);
+                std::memcpy(&result[value_offsets + i * sizeof(std::uint32_t)], &offset, sizeof(offset));
+                Serialize<BufferSize>::write_to(sink, value);
+            }
+            const std::uint32_t end = to_u32(result.size() - values);
+            std::memcpy(&result[value_offsets + order.size() * sizeof(std::uint32_t)], &end, sizeof(end));
+            return result;
+        }
+
+        /**
+         * @brief Reorder a sorted sequence in breadth first order of its implicit search tree (Eytzinger layout).
+         * 
+         * @tparam T Element datatype.
+         * @param sorted Elements in ascending order.
+         * @return std::vector<T> Elements in Eytzinger order.
+         */
+        template <typename T>
+        static std::vector<T> eytzinger_order(const std::vector<T> &sorted)
+        {
+            std::vector<T> result(sorted.size());
+            size_t next = 0;
+            fill_eytzinger(sorted, result, next, 1);
+            return result;
+        }
+
+    private:
+        template <typename T>
+        static void fill_eytzinger(const std::vector<T> &sorted, std::vector<T> &result, size_t &next, size_t node)
+        {
+            if (node <= sorted.size())
+            {
+                fill_eytzinger(sorted, result, next, 2 * node);
+                result[node - 1] = sorted[next++];
+                fill_eytzinger(sorted, result, next, 2 * node + 1);
+            }
+        }
+
+        static std::uint32_t to_u32(size_t value)
+        {
+            if (value > std::numeric_limits<std::uint32_t>::max())
+            {
+                throw std::runtime_error("Error while serializing sorted map, size does not fit in 32 bits.");
+            }
+            return static_cast<std::uint32_t>(value);
+        }
+
+        static void append_u32(std::string &result, std::uint32_t value)
+        {
+            result.append(reinterpret_cast<const char *>(&value), sizeof(value));
+        }
+    };
+
+    /**
+     * @brief Reader of the searchable map encoding, it works directly on the serialized bytes.
+     * Positions returned by lower_bound/find index the keys in storage order (ascending for the sorted layout), npos when there is no such key.
+     * 
+     * @tparam K Key datatype (std::string or std::string_view for string keys).
+     * @tparam V Value datatype, values are unserialized on request (std::string_view values point into the bytes).
+     */
+    template <typename K, typename V>
+    class SortedMapView
+    {
+    public:
+        using key_view = typename SortedMapKey<K>::view_type;
+        static constexpr size_t npos = static_cast<size_t>(-1);
+
+        SortedMapView() : keys(nullptr), value_offsets(nullptr), values(nullptr), values_size(0), count(0), layout(SortedMapLayout::sorted) {}
+
+        /**
+         * @brief Get a view of a serialized map, only the header and the offsets are checked (every key offset, the value offsets
+         * when a value is read).
+         * 
+         * @param data Pointer to the serialized map.
+         * @param size Size of the serialized map.
+         * @return SortedMapView View of the map.
+         */
+        static SortedMapView from(const void *data, size_t size)
+        {
+            const unsigned char *bytes = static_cast<const unsigned char *>(data);
+            const size_t header_size = SortedMapWriter<>::header_size;
+            if (size < header_size)
+            {
+                throw std::runtime_error("Error while reading sorted map, data size is too small to be parsed.");
+            }
+            std::uint64_t signature;
+            std::uint32_t header[4];
+            std::memcpy(&signature, bytes, sizeof(signature));
+            std::memcpy(header, bytes + sizeof(signature), sizeof(header));
+            if (signature != sorted_map_signature<K, V>())
+            {
+                throw std::runtime_error("Error while reading sorted map, key/value types are different from the serialized ones.");
+            }
+
+            if (header[1] != static_cast<std::uint32_t>(SortedMapLayout::sorted) && header[1] != static_cast<std::uint32_t>(SortedMapLayout::eytzinger))
+            {
+                throw std::runtime_error("Error while reading sorted map, unknown layout of the keys.");
+            }
+
+            SortedMapView view;
+            view.count = header[0];
+            view.layout = static_cast<SortedMapLayout>(header[1]);
+            view.keys = bytes + header_size;
+            size_t keys_size;
+            if constexpr (SortedMapKey<K>::fixed_width)
+            {
+                keys_size = sizeof(K) * view.count;
+                if (header[2] != sizeof(K) || keys_size > size - header_size)
+                {
+                    throw std::runtime_error("Error while reading sorted map, keys are bigger than the buffer.");
+                }
+            }
+            else
+            {
+                const size_t offsets_size = sizeof(std::uint32_t) * (view.count + 1);
+                if (header[2] != 0 || offsets_size > size - header_size)
+                {
+                    throw std::runtime_error("Error while reading sorted map, keys are bigger than the buffer.");
+                }
+                // Every key is read between two consecutive offsets, so all of them must be in order and inside the key bytes.
+                size_t previous = offsets_size;
+                for (size_t i = 0; i <= view.count; ++i)
+                {
+                    std::uint32_t offset;
+                    std::memcpy(&offset, view.keys + i * sizeof(std::uint32_t), sizeof(offset));
+                    if (offset < previous || offset > size - header_size)
+                    {
+                        throw std::runtime_error("Error while reading sorted map, key offsets are corrupted.");
+                    }
+                    previous = offset;
+                }
+                keys_size = previous;
+            }
+
+            const size_t value_offsets_size = sizeof(std::uint32_t) * (view.count + 1);
+            if (value_offsets_size > size - header_size - keys_size)
+            {
+                throw std::runtime_error("Error while reading sorted map, value offsets are bigger than the buffer.");
+            }
+            view.value_offsets = view.keys + keys_size;
+            view.values = view.value_offsets + value_offsets_size;
+            view.values_size = size - header_size - keys_size - value_offsets_size;
+            if (view.value_offset(view.count) > view.values_size)
+            {
+                throw std::runtime_error("Error while reading sorted map, values are bigger than the buffer.");
+            }
+            return view;
+        }
+
+        template <typename TData>
+        static SortedMapView from(const TData &data)
+        {
+            return from(data.data(), data.size());
+        }
+
+        size_t size() const
+        {
+            return count;
+        }
+
+        bool empty() const
+        {
+            return count == 0;
+        }
+
+        /**
+         * @brief Get the key stored at a position.
+         * 
+         * @param index Position of the key.
+         * @return key_view Key.
+         */
+        key_view key(size_t index) const
+        {
+            return SortedMapKey<K>::read(keys, index);
+        }
+
+        /**
+         * @brief Get the position of the first key not lower than the key given.
+         * 
+         * @param value Key to search.
+         * @return size_t Position of the key, npos if all the keys are lower.
+         */
+        size_t lower_bound(const key_view &value) const
+        {
+            if (layout == SortedMapLayout::eytzinger)
+            {
+                size_t node = 1;
+                while (node <= count)
+                {
+#if defined(__GNUC__)
+                    if (SortedMapKey<K>::fixed_width)
+                    {
+                        __builtin_prefetch(keys + 16 * node * sizeof(key_view));
+                    }
+#endif
+                    node = 2 * node + (key(node - 1) < value);
+                }
+                node >>= trailing_ones(node) + 1;
+                return node == 0 ? npos : node - 1;
+            }
+
+            size_t first = 0;
+            size_t length = count;
+            while (length > 0)
+            {
+                const size_t half = length / 2;
+                if (key(first + half) < value)
+                {
+                    first += half + 1;
+                    length -= half + 1;
+                }
+                else
+                {
+                    length = half;
+                }
+            }
+            return first == count ? npos : first;
+        }
+
+        /**
+         * @brief Get the position of a key.
+         * 
+         * @param value Key to search.
+         * @return size_t Position of the key, npos if it is not in the map.
+         */
+        size_t find(const key_view &value) const
+        {
+            const size_t index = lower_bound(value);
+            return index != npos && !(value < key(index)) ? index : npos;
+        }
+
+        /**
+         * @brief Get the serialized bytes of the value stored at a position.
+         * 
+         * @param index Position of the value.
+         * @return std::string_view Bytes of the value.
+         */
+        std::string_view value_bytes(size_t index) const
+        {
+            const size_t begin = value_offset(index);
+            const size_t end = value_offset(index + 1);
+            if (begin > end || end > values_size)
+            {
+                throw std::runtime_error("Error while reading sorted map, value offsets are corrupted.");
+            }
+            return std::string_view(reinterpret_cast<const char *>(values) + begin, end - begin);
+        }
+
+        /**
+         * @brief Unserialize the value stored at a position.
+         * 
+         * @param index Position of the value.
+         * @param result Reference to the object where the value will be stored.
+         */
+        void value(size_t index, V &result) const
+        {
+            const std::string_view bytes = value_bytes(index);
+            TypeUnserializer::apply(result, reinterpret_cast<unsigned char *>(const_cast<char *>(bytes.data())), bytes.size());
+        }
+
+        /**
+         * @brief Search a key and unserialize its value.
+         * 
+         * @param value_key Key to search.
+         * @param result Reference to the object where the value will be stored.
+         * @return true Key found, result has its value.
+         * @return false Key not found, result is untouched.
+         */
+        bool get(const key_view &value_key, V &result) const
+        {
+            const size_t index = find(value_key);
+            if (index == npos)
+            {
+                return false;
+            }
+            value(index, result);
+            return true;
+        }
+
+    private:
+        const unsigned char *keys;
+        const unsigned char *value_offsets;
+        const unsigned char *values;
+        size_t values_size;
+        size_t count;
+        SortedMapLayout layout;
+
+        /**
+         * @brief Number of consecutive 1 bits from the lowest bit, the Eytzinger search leaves them in the node of a right turn.
+         * 
+         */
+        static int trailing_ones(size_t node)
+        {
+#if defined(__GNUC__)
+            return __builtin_ctzll(~static_cast<unsigned long long>(node));
+#else
+            int ones = 0;
+            for (; node & 1; node >>= 1)
+            {
+                ++ones;
+            }
+            return ones;
+#endif
+        }
+
+        size_t value_offset(size_t index) const
+        {
+            std::uint32_t offset;
+            std::memcpy(&offset, value_offsets + index * sizeof(std::uint32_t), sizeof(offset));
+            return offset;
+        }
+    };
+};